@@ -0,0 +1,87 @@
+// A* Search
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// dijkstra() settles nodes in order of their cost from the source and so
+// spreads out evenly in every direction. When there is a single target
+// A* orders nodes by their cost from the source plus an estimate of the
+// cost remaining to the target. The search leans towards the target and
+// settles far fewer nodes. If the estimate never exceeds the true cost
+// (and obeys the triangle inequality) the route found is still a least
+// cost route. An estimate of zero everywhere turns A* back into dijkstra().
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <climits>
+#include <cstddef>
+
+#include "GraphView.h"
+
+// AStar() - A* from s to t on any GraphView.
+//
+// Parameters:
+//	const G & g				- the graph.
+//	int s					- the source node.
+//	int t					- the target node.
+//	H h						- h(u) estimates the cost from u to t.
+//	std::vector<int> & dist	- receives the cost to every settled node.
+//	std::vector<int> & prev	- receives the previous node on each route.
+//	size_t * expanded		- if not null, receives the number of nodes settled.
+// Returns:
+//	int						- the cost from s to t or INT_MAX if unreachable.
+template <GraphView G, typename H>
+int AStar(const G & g, int s, int t, H h, std::vector<int> & dist, std::vector<int> & prev,
+	size_t * expanded = nullptr)
+{
+	struct Entry
+	{
+		int f;		// cost so far plus estimate
+		int cost;	// cost so far
+		int node;
+
+		// On equal estimates prefer the node further along, it is more
+		// likely to be on the way to the target.
+		bool operator>(const Entry & o) const
+		{
+			return f != o.f ? f > o.f : cost < o.cost;
+		}
+	};
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+	size_t settled = 0;
+
+	dist.assign(g.NodeCount(), INT_MAX);
+	prev.assign(g.NodeCount(), -1);
+	dist[s] = 0;
+	q.push(Entry{ h(s), 0, s });
+
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.node;
+		if (e.cost != dist[u])
+			continue;
+		settled++;
+		if (u == t)
+			break;
+
+		for (auto edge : g.OutEdges(u))
+		{
+			int newDist = dist[u] + edge.weight;
+			if (newDist < dist[edge.to])
+			{
+				dist[edge.to] = newDist;
+				prev[edge.to] = u;
+				q.push(Entry{ newDist + h(edge.to), newDist, edge.to });
+			}
+		}
+	}
+
+	if (expanded)
+		*expanded = settled;
+	return dist[t];
+}
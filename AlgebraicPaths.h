@@ -0,0 +1,306 @@
+// Dense Algebraic Paths
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// For a dense graph small enough to hold as a matrix, Floyd-Warshall finds
+// the best route between every pair of nodes with three plain loops:
+//
+//	for every k, for every i, for every j:
+//		m[i][j] = better of (m[i][j], m[i][k] extended by m[k][j])
+//
+// As with PathSearch() (see Dijkstra.h) "better" and "extended" can be
+// chosen to answer different questions. Here each choice is a semiring:
+//
+//					combine (better)	extend		no route		diagonal
+//	MinPlus			min					+			infinity		0
+//	MaxMin			max					min			0				INT_MAX
+//	BoolOrAnd		or					and			false			true
+//
+// MinPlus gives shortest routes, MaxMin widest routes and BoolOrAnd which
+// nodes can reach which (the transitive closure).
+//
+// The innermost loop walks row i and row k side by side with m[i][k]
+// fixed, so it is done four ints (or sixteen bytes) at a time with SSE2
+// when the compiler offers it (__SSE2__, which every x86-64 compiler
+// does). Each semiring has its own SSE2 row; RowPlain() is the loop any
+// machine can run.
+//
+// MinPlus uses INT_MAX / 2 for no route, not INT_MAX. Then adding any two
+// entries cannot overflow, so the SSE2 row needs no test for infinity.
+// Route costs must stay below INT_MAX / 2.
+//
+// Reachability needs only one bit per pair. BitMatrix stores it that way,
+// 32 times smaller than a matrix of ints, and TransitiveClosure() works
+// on 128 bits at a time: when i reaches k, i reaches all that k reaches,
+// which is one OR of row k into row i.
+
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "GraphView.h"
+
+#ifdef __SSE2__
+// Min32(), Max32() - SSE2 has no 32 bit integer min and max (SSE4.1
+// does), so compare and select.
+inline __m128i Min32(__m128i a, __m128i b)
+{
+	__m128i a_bigger = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(a_bigger, b), _mm_andnot_si128(a_bigger, a));
+}
+
+inline __m128i Max32(__m128i a, __m128i b)
+{
+	__m128i a_bigger = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(a_bigger, a), _mm_andnot_si128(a_bigger, b));
+}
+#endif
+
+struct MinPlus
+{
+	typedef int Value;
+	static Value Zero() { return INT_MAX / 2; }
+	static Value One() { return 0; }
+	static Value FromWeight(int w) { return std::min(w, Zero()); }
+	static Value Combine(Value a, Value b) { return std::min(a, b); }
+	static Value Extend(Value a, Value b) { return a + b; }
+
+	// RowPlain() - row[j] = min(row[j], aik + rk[j]) for every j.
+	static void RowPlain(Value * row, const Value * rk, Value aik, int n)
+	{
+		for (int j = 0; j < n; j++)
+			row[j] = std::min(row[j], aik + rk[j]);
+	}
+
+	static void Row(Value * row, const Value * rk, Value aik, int n)
+	{
+#ifdef __SSE2__
+		__m128i a = _mm_set1_epi32(aik);
+		int j = 0;
+		for (; j + 4 <= n; j += 4)
+		{
+			__m128i r = _mm_loadu_si128((const __m128i *) (row + j));
+			__m128i k = _mm_loadu_si128((const __m128i *) (rk + j));
+			_mm_storeu_si128((__m128i *) (row + j), Min32(r, _mm_add_epi32(a, k)));
+		}
+		RowPlain(row + j, rk + j, aik, n - j);
+#else
+		RowPlain(row, rk, aik, n);
+#endif
+	}
+};
+
+struct MaxMin
+{
+	typedef int Value;
+	static Value Zero() { return 0; }
+	static Value One() { return INT_MAX; }
+	static Value FromWeight(int w) { return std::max(w, 0); }
+	static Value Combine(Value a, Value b) { return std::max(a, b); }
+	static Value Extend(Value a, Value b) { return std::min(a, b); }
+
+	// RowPlain() - row[j] = max(row[j], min(aik, rk[j])) for every j.
+	static void RowPlain(Value * row, const Value * rk, Value aik, int n)
+	{
+		for (int j = 0; j < n; j++)
+			row[j] = std::max(row[j], std::min(aik, rk[j]));
+	}
+
+	static void Row(Value * row, const Value * rk, Value aik, int n)
+	{
+#ifdef __SSE2__
+		__m128i a = _mm_set1_epi32(aik);
+		int j = 0;
+		for (; j + 4 <= n; j += 4)
+		{
+			__m128i r = _mm_loadu_si128((const __m128i *) (row + j));
+			__m128i k = _mm_loadu_si128((const __m128i *) (rk + j));
+			_mm_storeu_si128((__m128i *) (row + j), Max32(r, Min32(a, k)));
+		}
+		RowPlain(row + j, rk + j, aik, n - j);
+#else
+		RowPlain(row, rk, aik, n);
+#endif
+	}
+};
+
+// BoolOrAnd - one byte per pair. See BitMatrix for one bit per pair.
+struct BoolOrAnd
+{
+	typedef uint8_t Value;
+	static Value Zero() { return 0; }
+	static Value One() { return 1; }
+	static Value FromWeight(int) { return 1; }
+	static Value Combine(Value a, Value b) { return a | b; }
+	static Value Extend(Value a, Value b) { return a & b; }
+
+	// RowPlain() - aik is always true when a row is updated, so this is
+	// row[j] |= rk[j] for every j.
+	static void RowPlain(Value * row, const Value * rk, Value, int n)
+	{
+		for (int j = 0; j < n; j++)
+			row[j] |= rk[j];
+	}
+
+	static void Row(Value * row, const Value * rk, Value aik, int n)
+	{
+#ifdef __SSE2__
+		int j = 0;
+		for (; j + 16 <= n; j += 16)
+		{
+			__m128i r = _mm_loadu_si128((const __m128i *) (row + j));
+			__m128i k = _mm_loadu_si128((const __m128i *) (rk + j));
+			_mm_storeu_si128((__m128i *) (row + j), _mm_or_si128(r, k));
+		}
+		RowPlain(row + j, rk + j, aik, n - j);
+#else
+		RowPlain(row, rk, aik, n);
+#endif
+	}
+};
+
+// DenseMatrix() - the n by n matrix of a graph in semiring S: no route
+// everywhere, the diagonal set to One() and each edge's weight combined
+// into its entry.
+template <typename S, GraphView G>
+std::vector<typename S::Value> DenseMatrix(const G & g)
+{
+	int n = g.NodeCount();
+	std::vector<typename S::Value> m((size_t) n * n, S::Zero());
+	for (int u = 0; u < n; u++)
+	{
+		m[(size_t) u * n + u] = S::One();
+		for (auto e : g.OutEdges(u))
+			m[(size_t) u * n + e.to] = S::Combine(m[(size_t) u * n + e.to], S::FromWeight(e.weight));
+	}
+	return m;
+}
+
+// FloydWarshall() - replaces every entry of an n by n matrix with the
+// best route between its two nodes.
+//
+// Parameters:
+//	std::vector<...> & m	- the matrix, row major, as made by DenseMatrix().
+//	int n					- the number of nodes.
+//	bool simd				- false to use RowPlain() even where SSE2 is
+//							  available (for comparison).
+// Returns:
+//	none
+template <typename S>
+void FloydWarshall(std::vector<typename S::Value> & m, int n, bool simd = true)
+{
+	for (int k = 0; k < n; k++)
+	{
+		const typename S::Value * rk = &m[(size_t) k * n];
+		for (int i = 0; i < n; i++)
+		{
+			typename S::Value aik = m[(size_t) i * n + k];
+			// No route from i to k: nothing through k can help row i.
+			if (aik == S::Zero())
+				continue;
+			if (simd)
+				S::Row(&m[(size_t) i * n], rk, aik, n);
+			else
+				S::RowPlain(&m[(size_t) i * n], rk, aik, n);
+		}
+	}
+}
+
+// BitMatrix - an n by n matrix of bits, each row padded to a whole number
+// of 128 bit blocks.
+class BitMatrix
+{
+public:
+	explicit BitMatrix(int n = 0) : n(n), words(((n + 127) / 128) * 2), bits((size_t) n * words, 0)
+	{
+	}
+
+	int Size() const
+	{
+		return n;
+	}
+
+	bool Get(int i, int j) const
+	{
+		return (bits[(size_t) i * words + j / 64] >> (j % 64)) & 1;
+	}
+
+	void Set(int i, int j)
+	{
+		bits[(size_t) i * words + j / 64] |= 1ull << (j % 64);
+	}
+
+	uint64_t * Row(int i)
+	{
+		return &bits[(size_t) i * words];
+	}
+
+	int Words() const
+	{
+		return words;
+	}
+
+	size_t Bytes() const
+	{
+		return bits.size() * sizeof(uint64_t);
+	}
+
+private:
+	int n;
+	int words;
+	std::vector<uint64_t> bits;
+};
+
+// TransitiveClosure() - Warshall's algorithm on a BitMatrix.
+inline void TransitiveClosure(BitMatrix & r)
+{
+	int words = r.Words();
+	for (int k = 0; k < r.Size(); k++)
+	{
+		const uint64_t * rk = r.Row(k);
+		for (int i = 0; i < r.Size(); i++)
+		{
+			if (!r.Get(i, k))
+				continue;
+			uint64_t * ri = r.Row(i);
+#ifdef __SSE2__
+			for (int w = 0; w < words; w += 2)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i *) (ri + w));
+				__m128i b = _mm_loadu_si128((const __m128i *) (rk + w));
+				_mm_storeu_si128((__m128i *) (ri + w), _mm_or_si128(a, b));
+			}
+#else
+			for (int w = 0; w < words; w++)
+				ri[w] |= rk[w];
+#endif
+		}
+	}
+}
+
+// ReachabilityMatrix() - bit (u, v) is set when u can reach v. Every node
+// reaches itself.
+template <GraphView G>
+BitMatrix ReachabilityMatrix(const G & g)
+{
+	int n = g.NodeCount();
+	BitMatrix r(n);
+	for (int u = 0; u < n; u++)
+	{
+		r.Set(u, u);
+		for (auto e : g.OutEdges(u))
+			r.Set(u, e.to);
+	}
+	TransitiveClosure(r);
+	return r;
+}
@@ -0,0 +1,83 @@
+// All Pairs Shortest Paths
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// All pairs shortest paths is just dijkstra() run once from every node.
+// The runs do not depend on one another so they are farmed out to as
+// many threads as are asked for. Each thread owns its own dist and
+// previous_node vectors (the globals in Source.cpp would be trampled).
+//
+// The results are too big to keep (V * V of each) so every finished row
+// is handed to a "sink" supplied by the caller which can print it, pack
+// it into a file or throw most of it away.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+#include "Dijkstra.h"
+
+// The sink is called once per source with that source's results. It is
+// called from the worker threads, in no particular order, so it must be
+// safe to call concurrently.
+typedef std::function<void(int s, const std::vector<int> & dist, const std::vector<int> & prev)> ApspSink;
+
+// ParallelApsp() - runs DijkstraFrom() from every node using the given
+// number of threads. Sources are handed out in increasing order from a
+// shared counter so at any moment the rows in flight are close together.
+// Sinks that gather rows into blocks rely on this to bound their memory.
+//
+// S may be ShortestFewestEdges (see Dijkstra.h) instead, for previous
+// nodes that break ties between equally cheap routes the same way from
+// every source. The sink still receives plain costs.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	int threads					- how many worker threads (0 means one per core).
+//	const ApspSink & sink		- receives each row as it is finished.
+// Returns:
+//	none
+template <typename S = ShortestPath, GraphView G>
+void ParallelApsp(const G & g, int threads, const ApspSink & sink)
+{
+	int n = g.NodeCount();
+	std::atomic<int> next(0);
+	std::vector<std::thread> workers;
+
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	auto work = [&]()
+	{
+		std::vector<int> dist, prev;
+		std::vector<typename S::Value> value;
+		for (int s = next++; s < n; s = next++)
+		{
+			if constexpr (std::is_same_v<S, ShortestPath>)
+				PathSearch<S>(g, s, dist, prev);
+			else
+			{
+				PathSearch<S>(g, s, value, prev);
+				dist.resize(n);
+				for (int v = 0; v < n; v++)
+					dist[v] = S::Cost(value[v]);
+			}
+			sink(s, dist, prev);
+		}
+	};
+
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(work));
+	work();
+	for (auto & t : workers)
+		t.join();
+}
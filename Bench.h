@@ -0,0 +1,1148 @@
+// Benchmarks
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// The graphs shipped with the demo are far too small to time anything
+// so the benchmarks make their own. Each benchmark prints one line per
+// variant it times: the variant's name and the seconds it took. The
+// numbers are only meaningful relative to each other on the same run.
+
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <climits>
+#include <functional>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <numeric>
+
+#include "GraphView.h"
+#include "Dijkstra.h"
+#include "AStar.h"
+#include "Jps.h"
+#include "ParallelSssp.h"
+#include "GraphFile.h"
+#include "Geometry.h"
+#include "SpatialIndex.h"
+#include "CostMatrix.h"
+#include "Apsp.h"
+#include "NextHop.h"
+#include "Tsp.h"
+#include "MaxFlow.h"
+#include "MinCostFlow.h"
+#include "AlgebraicPaths.h"
+#include "Reachability.h"
+
+// TimeIt() - seconds taken by one call to f.
+template <typename F>
+double TimeIt(F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+	return d.count();
+}
+
+// BenchReport() - prints one line of benchmark results.
+inline void BenchReport(const std::string & name, double seconds)
+{
+	std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+		<< std::setprecision(4) << std::setw(10) << seconds << " s" << std::endl;
+}
+
+// RandomDenseMatrix() - a symmetric graph in the demo's dense format where
+// each possible edge is present with the given probability.
+inline std::vector<int> RandomDenseMatrix(int n, double density, int max_weight, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> coin(0, 1);
+	std::uniform_int_distribution<int> weight(1, max_weight);
+	std::vector<int> g((size_t) n * n, -1);
+
+	for (int u = 0; u < n; u++)
+		for (int v = u + 1; v < n; v++)
+			if (coin(rng) < density)
+				g[(size_t) n * u + v] = g[(size_t) n * v + u] = weight(rng);
+	return g;
+}
+
+// RandomSparseGraph() - a symmetric graph in CSR form. Every node is
+// joined to the next so the graph is connected, then each node gets
+// degree / 2 more edges to random nodes.
+inline CsrGraph RandomSparseGraph(int n, int degree, int max_weight, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> node(0, n - 1);
+	std::uniform_int_distribution<int> weight(1, max_weight);
+	std::vector<std::vector<Edge>> adj(n);
+
+	auto join = [&](int u, int v)
+	{
+		int w = weight(rng);
+		adj[u].push_back(Edge{ v, w });
+		adj[v].push_back(Edge{ u, w });
+	};
+	for (int u = 0; u + 1 < n; u++)
+		join(u, u + 1);
+	for (int u = 0; u < n; u++)
+		for (int i = 0; i < degree / 2; i++)
+			join(u, node(rng));
+
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		edges.insert(edges.end(), adj[u].begin(), adj[u].end());
+		offsets[u + 1] = edges.size();
+	}
+	return CsrGraph(std::move(offsets), std::move(edges));
+}
+
+// RandomPowerLawGraph() - a symmetric graph in CSR form whose degrees
+// follow a power law, as in social and web graphs: a few hubs with a
+// great many edges and a great many nodes with very few (Chung and Lu).
+// Node i is chosen as an edge end with probability proportional to
+// (i + 1) ^ (-1 / (exponent - 1)).
+inline CsrGraph RandomPowerLawGraph(int n, int degree, int max_weight, double exponent, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> weight(1, max_weight);
+	std::vector<double> chance(n);
+	std::vector<std::vector<Edge>> adj(n);
+
+	for (int i = 0; i < n; i++)
+		chance[i] = std::pow(i + 1.0, -1.0 / (exponent - 1));
+	std::discrete_distribution<int> node(chance.begin(), chance.end());
+
+	for (long long i = 0; i < (long long) n * degree / 2; i++)
+	{
+		int u = node(rng);
+		int v = node(rng);
+		int w = weight(rng);
+		adj[u].push_back(Edge{ v, w });
+		adj[v].push_back(Edge{ u, w });
+	}
+
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		edges.insert(edges.end(), adj[u].begin(), adj[u].end());
+		offsets[u + 1] = edges.size();
+	}
+	return CsrGraph(std::move(offsets), std::move(edges));
+}
+
+// RandomCostGrid() - a rows x cols grid of cell costs from 1 to max_cost
+// with the given fraction of cells blocked (-1).
+inline std::vector<int> RandomCostGrid(int rows, int cols, int max_cost, double blocked, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> coin(0, 1);
+	std::uniform_int_distribution<int> cost(1, max_cost);
+	std::vector<int> grid((size_t) rows * cols);
+
+	for (auto & c : grid)
+		c = coin(rng) < blocked ? -1 : cost(rng);
+	return grid;
+}
+
+// The "by hand" searches below are what one would write without graph
+// views, each specialized to one storage format. BenchViews() times them
+// against DijkstraFrom() given the equivalent view. If views cost
+// anything the generic times would be consistently worse.
+
+inline void DenseByHand(const std::vector<int> & g, int n, int s, std::vector<int> & dist, std::vector<int> & prev)
+{
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+
+	dist.assign(n, INT_MAX);
+	prev.assign(n, -1);
+	dist[s] = 0;
+	q.push(Entry(0, s));
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+		const int * row = &g[(size_t) n * u];
+		for (int v = 0; v < n; v++)
+		{
+			if (row[v] == -1)
+				continue;
+			int newDist = dist[u] + row[v];
+			if (newDist < dist[v])
+			{
+				dist[v] = newDist;
+				prev[v] = u;
+				q.push(Entry(newDist, v));
+			}
+		}
+	}
+}
+
+inline void CsrByHand(const std::vector<size_t> & offsets, const std::vector<Edge> & edges, int s,
+	std::vector<int> & dist, std::vector<int> & prev)
+{
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+
+	dist.assign(offsets.size() - 1, INT_MAX);
+	prev.assign(offsets.size() - 1, -1);
+	dist[s] = 0;
+	q.push(Entry(0, s));
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+		for (size_t i = offsets[u]; i < offsets[u + 1]; i++)
+		{
+			int v = edges[i].to;
+			int newDist = dist[u] + edges[i].weight;
+			if (newDist < dist[v])
+			{
+				dist[v] = newDist;
+				prev[v] = u;
+				q.push(Entry(newDist, v));
+			}
+		}
+	}
+}
+
+inline void GridByHand(const std::vector<int> & cost, int rows, int cols, int s, std::vector<int> & dist, std::vector<int> & prev)
+{
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+
+	dist.assign((size_t) rows * cols, INT_MAX);
+	prev.assign((size_t) rows * cols, -1);
+	dist[s] = 0;
+	q.push(Entry(0, s));
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+		int r = u / cols;
+		int c = u % cols;
+		int next[4];
+		int count = 0;
+		if (r > 0)
+			next[count++] = u - cols;
+		if (c > 0)
+			next[count++] = u - 1;
+		if (c + 1 < cols)
+			next[count++] = u + 1;
+		if (r + 1 < rows)
+			next[count++] = u + cols;
+		for (int i = 0; i < count; i++)
+		{
+			int v = next[i];
+			if (cost[v] == -1)
+				continue;
+			int newDist = dist[u] + cost[v];
+			if (newDist < dist[v])
+			{
+				dist[v] = newDist;
+				prev[v] = u;
+				q.push(Entry(newDist, v));
+			}
+		}
+	}
+}
+
+// BenchViews() - times hand written searches against the generic one on
+// the same graphs. The results are compared too, so a broken view shows
+// up as an error rather than as a suspiciously fast time.
+//
+// Parameters:
+//	int n		- the number of nodes in the sparse graph. The dense graph
+//				  and the grid are sized to take comparable time.
+//	int sources	- how many searches to time for each variant.
+// Returns:
+//	bool		- false if any generic result differed from the hand written one.
+inline bool BenchViews(int n, int sources)
+{
+	std::vector<int> a, b, prev;
+	bool ok = true;
+
+	int dense_n = std::max(2, n / 50);
+	std::vector<int> dense = RandomDenseMatrix(dense_n, 0.1, 100, 1);
+	DenseView dense_view(dense, dense_n);
+	double by_hand = 0, generic = 0;
+	for (int s = 0; s < sources; s++)
+	{
+		by_hand += TimeIt([&]() { DenseByHand(dense, dense_n, s % dense_n, a, prev); });
+		generic += TimeIt([&]() { DijkstraFrom(dense_view, s % dense_n, b, prev); });
+		ok = ok && a == b;
+	}
+	BenchReport("dense by hand (" + std::to_string(dense_n) + " nodes)", by_hand);
+	BenchReport("dense through DenseView", generic);
+
+	CsrGraph csr = RandomSparseGraph(n, 8, 100, 2);
+	by_hand = generic = 0;
+	for (int s = 0; s < sources; s++)
+	{
+		by_hand += TimeIt([&]() { CsrByHand(csr.Offsets(), csr.Edges(), s % n, a, prev); });
+		generic += TimeIt([&]() { DijkstraFrom(csr, s % n, b, prev); });
+		ok = ok && a == b;
+	}
+	BenchReport("CSR by hand (" + std::to_string(n) + " nodes)", by_hand);
+	BenchReport("CSR through CsrGraph", generic);
+
+	int side = std::max(2, (int) std::sqrt((double) n));
+	std::vector<int> grid = RandomCostGrid(side, side, 9, 0.2, 3);
+	grid[0] = 1;
+	GridView grid_view(grid, side, side);
+	by_hand = generic = 0;
+	for (int s = 0; s < sources; s++)
+	{
+		int src = (s * 7919) % (side * side);
+		if (grid[src] == -1)
+			src = 0;
+		by_hand += TimeIt([&]() { GridByHand(grid, side, side, src, a, prev); });
+		generic += TimeIt([&]() { DijkstraFrom(grid_view, src, b, prev); });
+		ok = ok && a == b;
+	}
+	BenchReport("grid by hand (" + std::to_string(side) + " x " + std::to_string(side) + ")", by_hand);
+	BenchReport("grid through GridView", generic);
+
+	if (!ok)
+		std::cerr << "Generic results differ from hand written results." << std::endl;
+	return ok;
+}
+
+// RoomsGrid() - a uniform cost size x size grid divided into square rooms
+// by walls one cell thick, with a door of random width in each wall. This
+// is the kind of map the "rooms" maps of the Moving AI benchmark sets are.
+inline std::vector<int> RoomsGrid(int size, int room, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> place(1, room - 2);
+	std::vector<int> grid((size_t) size * size, 1);
+
+	for (int r = 0; r < size; r++)
+		for (int c = 0; c < size; c++)
+			if (r % room == room - 1 || c % room == room - 1)
+				grid[(size_t) r * size + c] = -1;
+
+	// Punch a door through every wall segment.
+	for (int r0 = 0; r0 < size; r0 += room)
+	{
+		for (int c0 = 0; c0 < size; c0 += room)
+		{
+			int wall_c = c0 + room - 1;
+			int wall_r = r0 + room - 1;
+			int door = place(rng);
+			for (int i = door; i < std::min(door + 1 + (int) (rng() % 3), room - 1); i++)
+			{
+				if (wall_c < size && r0 + i < size)
+					grid[(size_t) (r0 + i) * size + wall_c] = 1;
+				if (wall_r < size && c0 + i < size)
+					grid[(size_t) wall_r * size + c0 + i] = 1;
+			}
+		}
+	}
+	return grid;
+}
+
+// BenchJpsMap() - times A* and the three jump point search variants on
+// one map over the same random queries and checks they agree.
+inline bool BenchJpsMap(const std::string & name, const std::vector<int> & cost, int size, int queries)
+{
+	GridView g(cost, size, size, 8);
+	std::mt19937 rng(5);
+	std::uniform_int_distribution<int> cell(0, size * size - 1);
+	std::vector<std::pair<int, int>> pairs;
+	std::vector<int> expected, dist, prev, path;
+	bool ok = true;
+
+	while ((int) pairs.size() < queries)
+	{
+		int s = cell(rng);
+		int t = cell(rng);
+		if (!g.Blocked(s) && !g.Blocked(t))
+			pairs.push_back(std::make_pair(s, t));
+	}
+
+	std::cout << name << " " << size << " x " << size << ", " << queries << " queries" << std::endl;
+	BenchReport("  A*", TimeIt([&]()
+	{
+		for (auto & q : pairs)
+			expected.push_back(AStar(g, q.first, q.second, [&](int u) { return g.Heuristic(u, q.second); }, dist, prev));
+	}));
+
+	const char * names[] = { "  JPS, cell by cell", "  JPS, bit scanning", "  JPS+" };
+	for (int v = jps_scan; v <= jps_plus; v++)
+	{
+		std::vector<int> got;
+		std::unique_ptr<JumpPointSearch> jps;
+		double build = TimeIt([&]() { jps = std::make_unique<JumpPointSearch>(g, (JpsVariant) v); });
+		if (v == jps_plus)
+			BenchReport("  JPS+ table build", build);
+		BenchReport(names[v], TimeIt([&]()
+		{
+			for (auto & q : pairs)
+				got.push_back(jps->Search(q.first, q.second, path));
+		}));
+		ok = ok && got == expected;
+	}
+	if (!ok)
+		std::cerr << "Jump point search disagrees with A* on " << name << std::endl;
+	return ok;
+}
+
+// BenchJps() - BenchJpsMap() on random obstacle maps and rooms maps at
+// the sizes common in the Moving AI grid benchmarks (256 to 1024 square,
+// plus 2048 for a larger case).
+inline bool BenchJps(int queries)
+{
+	bool ok = true;
+
+	for (int size : { 256, 512, 1024, 2048 })
+	{
+		ok = BenchJpsMap("random 20%", RandomCostGrid(size, size, 1, 0.2, size), size, queries) && ok;
+		ok = BenchJpsMap("rooms 32", RoomsGrid(size, 32, size), size, queries) && ok;
+	}
+	return ok;
+}
+
+// BenchSsspGraph() - times dijkstra() against the parallel searches on
+// one graph and checks that they agree. Building the graph's CSR form
+// with one thread and with several is timed and compared too.
+inline bool BenchSsspGraph(const std::string & name, const CsrGraph & g, int threads, int sources)
+{
+	int n = g.NodeCount();
+	std::vector<std::vector<int>> expected(sources);
+	std::vector<int> dist, prev;
+	FrontierStats stats;
+	CsrGraph serial, parallel;
+	bool ok = true;
+
+	std::cout << name << ": " << n << " nodes, " << g.EdgeCount() << " edges" << std::endl;
+	BenchReport("  build CSR", TimeIt([&]() { serial = CsrGraph(g); }));
+	BenchReport("  build CSR, " + std::to_string(threads) + " threads", TimeIt([&]() { parallel = CsrGraph(g, threads); }));
+	ok = serial.Offsets() == parallel.Offsets() && std::equal(serial.Edges().begin(), serial.Edges().end(),
+		parallel.Edges().begin(), parallel.Edges().end(),
+		[](const Edge & a, const Edge & b) { return a.to == b.to && a.weight == b.weight; });
+	BenchReport("  dijkstra()", TimeIt([&]()
+	{
+		for (int i = 0; i < sources; i++)
+			DijkstraFrom(g, i * 7919 % n, expected[i], prev);
+	}));
+	BenchReport("  parallel buckets, " + std::to_string(threads) + " threads", TimeIt([&]()
+	{
+		for (int i = 0; i < sources; i++)
+		{
+			ParallelDial(g, i * 7919 % n, threads, 0, dist, prev);
+			ok = ok && dist == expected[i];
+		}
+	}));
+	BenchReport("  frontier, " + std::to_string(threads) + " threads", TimeIt([&]()
+	{
+		for (int i = 0; i < sources; i++)
+		{
+			FrontierSssp(g, i * 7919 % n, threads, dist, prev, &stats);
+			ok = ok && dist == expected[i];
+		}
+	}));
+	std::cout << "  frontier rounds: " << stats.rounds << " (" << stats.dense_rounds << " dense)" << std::endl;
+	return ok;
+}
+
+// BenchSssp() - BenchSsspGraph() on a uniform random graph and on a power
+// law graph, both with small integer weights.
+//
+// Parameters:
+//	int n		- the number of nodes.
+//	int threads	- threads for the parallel searches.
+//	int sources	- how many searches to time for each.
+// Returns:
+//	bool		- false if any parallel result or parallel build differed.
+inline bool BenchSssp(int n, int threads, int sources)
+{
+	bool ok = BenchSsspGraph("uniform random", RandomSparseGraph(n, 8, 10, 6), threads, sources);
+	ok = BenchSsspGraph("power law", RandomPowerLawGraph(n, 8, 10, 2.2, 7), threads, sources) && ok;
+	if (!ok)
+		std::cerr << "Parallel results differ from dijkstra() or from the serial CSR build." << std::endl;
+	return ok;
+}
+
+// BenchLoad() - writes a generated graph to path as a binary graph file
+// and times loading it back each way. The file is dropped from the page
+// cache before each load so every load starts cold.
+inline bool BenchLoad(const std::string & path, int n)
+{
+	CsrGraph g = RandomPowerLawGraph(n, 8, 10, 2.2, 8);
+	std::vector<int> expected, d, prev;
+	const char * names[] = { "mmap", "read()", "io_uring" };
+	bool ok = true;
+
+	if (!SaveGraphFile(g, path))
+	{
+		std::cerr << "Could not write " << path << "." << std::endl;
+		return false;
+	}
+	std::cout << "Graph file: " << GraphImageLayout(g.NodeCount(), g.EdgeCount()).size / (1 << 20) << " MB" << std::endl;
+	DijkstraFrom(g, 0, expected, prev);
+	for (int m = load_mmap; m <= load_uring; m++)
+	{
+		GraphFile f;
+		bool loaded = false;
+		DropFromPageCache(path);
+		double seconds = TimeIt([&]() { loaded = f.Load(path, (GraphFileMethod) m); });
+		std::string name = names[m];
+		if (f.Method() != m)
+			name += " (fell back to read())";
+		if (f.HugePages())
+			name += " huge pages";
+		BenchReport(name, seconds);
+		if (loaded)
+			DijkstraFrom(f, 0, d, prev);
+		ok = ok && loaded && d == expected;
+	}
+	unlink(path.c_str());
+	if (!ok)
+		std::cerr << "A loaded graph differs from the one written." << std::endl;
+	return ok;
+}
+
+// RandomGeometricGraph() - n points scattered over a square with about one
+// point per unit of area, each joined to every point within 1.4 units
+// (about six neighbors). An edge costs 100 per unit of length times a
+// random factor between 1 and 2, so the geometric bound is useful but not
+// exact.
+inline CsrGraph RandomGeometricGraph(int n, unsigned seed, Coordinates & c)
+{
+	std::mt19937 rng(seed);
+	double side = std::sqrt((double) n);
+	double radius = 1.4;
+	std::uniform_real_distribution<float> place(0, (float) side);
+	std::uniform_real_distribution<double> factor(1, 2);
+	int cells = std::max(1, (int) (side / radius));
+	std::vector<std::vector<int>> cell(cells * cells);
+	std::vector<std::vector<Edge>> adj(n);
+
+	c.geographic = false;
+	c.x.resize(n);
+	c.y.resize(n);
+	auto cell_of = [&](float v) { return std::min(cells - 1, (int) (v / side * cells)); };
+	for (int i = 0; i < n; i++)
+	{
+		c.x[i] = place(rng);
+		c.y[i] = place(rng);
+		cell[cell_of(c.y[i]) * cells + cell_of(c.x[i])].push_back(i);
+	}
+	for (int u = 0; u < n; u++)
+	{
+		int cx = cell_of(c.x[u]);
+		int cy = cell_of(c.y[u]);
+		for (int y = std::max(0, cy - 1); y <= std::min(cells - 1, cy + 1); y++)
+		{
+			for (int x = std::max(0, cx - 1); x <= std::min(cells - 1, cx + 1); x++)
+			{
+				for (int v : cell[y * cells + x])
+				{
+					double d = c.Distance(u, v);
+					if (v > u && d <= radius)
+					{
+						int w = std::max(1, (int) std::ceil(d * 100 * factor(rng)));
+						adj[u].push_back(Edge{ v, w });
+						adj[v].push_back(Edge{ u, w });
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		edges.insert(edges.end(), adj[u].begin(), adj[u].end());
+		offsets[u + 1] = edges.size();
+	}
+	return CsrGraph(std::move(offsets), std::move(edges));
+}
+
+// BenchGeometry() - times point to point queries by dijkstra() and by A*
+// with the geometric bound, before and after renumbering the nodes along
+// a Hilbert curve, and times snapping points to nodes with a k-d tree.
+inline bool BenchGeometry(int n, int queries)
+{
+	Coordinates c;
+	CsrGraph g = RandomGeometricGraph(n, 9, c);
+	std::mt19937 rng(10);
+	std::uniform_int_distribution<int> node(0, n - 1);
+	std::vector<std::pair<int, int>> pairs(queries);
+	std::vector<int> expected(queries), dist, prev;
+	size_t dijkstra_settled = 0;
+	size_t astar_settled = 0;
+	bool ok = true;
+
+	std::cout << "Geometric graph: " << n << " nodes, " << g.EdgeCount() << " edges" << std::endl;
+	for (auto & q : pairs)
+		q = std::make_pair(node(rng), node(rng));
+
+	BenchReport("  dijkstra() to target", TimeIt([&]()
+	{
+		for (int i = 0; i < queries; i++)
+		{
+			size_t settled;
+			expected[i] = AStar(g, pairs[i].first, pairs[i].second, [](int) { return 0; }, dist, prev, &settled);
+			dijkstra_settled += settled;
+		}
+	}));
+	GeometricBound bound(g, c);
+	BenchReport("  A*, geometric bound", TimeIt([&]()
+	{
+		for (int i = 0; i < queries; i++)
+		{
+			size_t settled;
+			int t = pairs[i].second;
+			ok = AStar(g, pairs[i].first, t, [&](int u) { return bound(u, t); }, dist, prev, &settled) == expected[i] && ok;
+			astar_settled += settled;
+		}
+	}));
+	std::cout << "  nodes settled per query: " << dijkstra_settled / queries << " by dijkstra(), ";
+	std::cout << astar_settled / queries << " by A*" << std::endl;
+
+	std::vector<int> order = HilbertOrder(c);
+	std::vector<int> rank(n);
+	for (int i = 0; i < n; i++)
+		rank[order[i]] = i;
+	CsrGraph sorted = Renumbered(g, order);
+	Coordinates sorted_c = c;
+	sorted_c.Permute(order);
+	GeometricBound sorted_bound(sorted, sorted_c);
+	BenchReport("  A*, geometric bound, Hilbert order", TimeIt([&]()
+	{
+		for (int i = 0; i < queries; i++)
+		{
+			int t = rank[pairs[i].second];
+			ok = AStar(sorted, rank[pairs[i].first], t, [&](int u) { return sorted_bound(u, t); }, dist, prev) == expected[i] && ok;
+		}
+	}));
+
+	KdTree tree(c);
+	std::uniform_real_distribution<float> place(0, (float) std::sqrt((double) n));
+	std::vector<std::pair<float, float>> points(100000);
+	for (auto & p : points)
+		p = std::make_pair(place(rng), place(rng));
+	int snapped = 0;
+	BenchReport("  k-d tree, " + std::to_string(points.size()) + " snaps", TimeIt([&]()
+	{
+		for (auto & p : points)
+			snapped += tree.Nearest(p.first, p.second) >= 0;
+	}));
+	for (int i = 0; i < 100; i++)
+	{
+		auto [x, y] = points[i];
+		int found = tree.Nearest(x, y);
+		for (int v = 0; v < n; v++)
+			ok = ok && c.Distance(x, y, c.x[found], c.y[found]) <= c.Distance(x, y, c.x[v], c.y[v]);
+	}
+	if (!ok)
+		std::cerr << "Geometric results differ from dijkstra() or brute force." << std::endl;
+	return ok && snapped == (int) points.size();
+}
+
+// BenchSnap() - times snapping random points to the nodes and edges of a
+// geometric graph, one point at a time and in parallel batches, and
+// checks a sample of the answers by brute force.
+inline bool BenchSnap(int n, int threads)
+{
+	Coordinates c;
+	CsrGraph g = RandomGeometricGraph(n, 11, c);
+	std::mt19937 rng(12);
+	std::uniform_real_distribution<float> place(0, (float) std::sqrt((double) n));
+	size_t count = 1000000;
+	std::vector<float> px(count), py(count);
+	std::vector<int> nodes;
+	std::vector<EdgeSnap> snaps;
+	bool ok = true;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		px[i] = place(rng);
+		py[i] = place(rng);
+	}
+	std::cout << "Geometric graph: " << n << " nodes, " << g.EdgeCount() << " edges, ";
+	std::cout << count << " points" << std::endl;
+
+	KdTree tree(c);
+	SpatialIndex index(g, c);
+	// The answers are added up and stored to a volatile so the compiler
+	// cannot drop the timed loops as unused.
+	int64_t sum = 0;
+	BenchReport("  nearest node, k-d tree", TimeIt([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			sum += tree.Nearest(px[i], py[i]);
+	}));
+	BenchReport("  nearest node, packed R-tree", TimeIt([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			sum -= index.NearestNode(px[i], py[i]);
+	}));
+	BenchReport("  nearest edge, packed R-tree", TimeIt([&]()
+	{
+		for (size_t i = 0; i < count; i++)
+			sum += index.NearestEdge(px[i], py[i]).from;
+	}));
+	BenchReport("  nearest node, " + std::to_string(threads) + " threads", TimeIt([&]()
+	{
+		index.SnapNodes(px, py, nodes, threads);
+	}));
+	BenchReport("  nearest edge, " + std::to_string(threads) + " threads", TimeIt([&]()
+	{
+		index.SnapEdges(px, py, snaps, threads);
+	}));
+
+	for (size_t i = 0; i < 200; i++)
+	{
+		double best_node = INFINITY;
+		double best_edge = INFINITY;
+		for (int u = 0; u < n; u++)
+		{
+			best_node = std::min(best_node, c.Distance(px[i], py[i], c.x[u], c.y[u]));
+			for (auto e : g.OutEdges(u))
+			{
+				double dx = c.x[e.to] - c.x[u];
+				double dy = c.y[e.to] - c.y[u];
+				double len2 = std::max(dx * dx + dy * dy, 1e-30);
+				double t = std::clamp(((px[i] - c.x[u]) * dx + (py[i] - c.y[u]) * dy) / len2, 0.0, 1.0);
+				best_edge = std::min(best_edge, std::hypot(px[i] - c.x[u] - t * dx, py[i] - c.y[u] - t * dy));
+			}
+		}
+		ok = ok && std::abs(c.Distance(px[i], py[i], c.x[nodes[i]], c.y[nodes[i]]) - best_node) < 1e-3;
+		ok = ok && std::abs(snaps[i].distance - best_edge) < 1e-3;
+	}
+	if (!ok)
+		std::cerr << "Snapped points differ from brute force." << std::endl;
+	volatile int64_t keep = sum;
+	(void) keep;
+	return ok;
+}
+
+// BenchMatrix() - times the cost matrix between random points of a
+// geometric graph, searching every row and then only the upper triangle,
+// and checks that both give the same matrix.
+inline bool BenchMatrix(int n, int points, int threads)
+{
+	Coordinates c;
+	CsrGraph g = RandomGeometricGraph(n, 13, c);
+	std::vector<int> order(n);
+	std::vector<int> full, upper;
+	size_t full_settled = 0, upper_settled = 0;
+
+	std::iota(order.begin(), order.end(), 0);
+	std::shuffle(order.begin(), order.end(), std::mt19937(14));
+	order.resize(points);
+	std::cout << "Geometric graph: " << n << " nodes, " << g.EdgeCount() << " edges, ";
+	std::cout << points << " points, " << threads << " threads" << std::endl;
+
+	BenchReport("  every row", TimeIt([&]()
+	{
+		full_settled = CostMatrix(g, order, false, threads, full);
+	}));
+	BenchReport("  upper triangle", TimeIt([&]()
+	{
+		upper_settled = CostMatrix(g, order, true, threads, upper);
+	}));
+	std::cout << "  nodes settled: " << full_settled << " against " << upper_settled << std::endl;
+	if (full != upper)
+	{
+		std::cerr << "The upper triangle differs from the full matrix." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// BenchTsp() - times the tour heuristics on points scattered over a
+// square with straight line costs, using one thread and then threads
+// threads to find 2-opt moves.
+inline bool BenchTsp(int points, int threads)
+{
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<double> place(0, 1000);
+	std::vector<double> x(points), y(points);
+	std::vector<int> matrix((size_t) points * points);
+	std::vector<int> tour;
+	TspStats one, many;
+
+	for (int i = 0; i < points; i++)
+	{
+		x[i] = place(rng);
+		y[i] = place(rng);
+	}
+	for (int i = 0; i < points; i++)
+		for (int j = 0; j < points; j++)
+			matrix[(size_t) i * points + j] = (int) std::lround(100 * std::hypot(x[i] - x[j], y[i] - y[j]));
+	std::cout << points << " points, straight line costs" << std::endl;
+
+	DenseCosts costs(matrix, points);
+	BenchReport("  local search, 1 thread", TimeIt([&]()
+	{
+		TspSolver<DenseCosts>(costs, points, 8, 1).Solve(tour, &one);
+	}));
+	BenchReport("  local search, " + std::to_string(threads) + " threads", TimeIt([&]()
+	{
+		TspSolver<DenseCosts>(costs, points, 8, threads).Solve(tour, &many);
+	}));
+	std::cout << "  nearest neighbor tour: " << one.nearest_neighbor << std::endl;
+	std::cout << "  improved tour:         " << one.cost << " (" << one.two_opt_moves << " 2-opt, ";
+	std::cout << one.or_opt_moves << " Or-opt moves)" << std::endl;
+
+	std::vector<int> sorted = tour;
+	std::sort(sorted.begin(), sorted.end());
+	for (int i = 0; i < points; i++)
+	{
+		if (sorted[i] != i)
+		{
+			std::cerr << "The tour does not visit every point once." << std::endl;
+			return false;
+		}
+	}
+	return many.cost == TourCost(costs, tour) && one.cost <= one.nearest_neighbor;
+}
+
+// BenchFlowGraph() - times the maximum flow across a graph from node 0 to
+// its last node and checks that the flow equals the capacity of the cut
+// found, which proves both are optimal.
+inline bool BenchFlowGraph(const std::string & name, const CsrGraph & g)
+{
+	int n = g.NodeCount();
+	int64_t value = 0;
+	double build = 0;
+
+	std::cout << name << ": " << n << " nodes, " << g.EdgeCount() << " edges" << std::endl;
+	std::unique_ptr<MaxFlow> flow;
+	build = TimeIt([&]() { flow = std::make_unique<MaxFlow>(g); });
+	BenchReport("  build residual graph", build);
+	BenchReport("  push-relabel", TimeIt([&]() { value = flow->Solve(0, n - 1); }));
+
+	int64_t cut = flow->CutCapacity();
+	std::cout << "  flow " << value << ", " << flow->Relabels() << " relabels, ";
+	std::cout << flow->GlobalRelabels() << " global relabels" << std::endl;
+	bool ok = cut == value && flow->SourceSide(0) && !flow->SourceSide(n - 1);
+	if (!ok)
+		std::cerr << "The flow and the cut differ." << std::endl;
+	return ok;
+}
+
+// BenchFlow() - BenchFlowGraph() on a uniform random graph and on a
+// geometric graph, whose long thin routes are much harder. A small random
+// graph whose minimum cut includes parallel edges is checked too.
+inline bool BenchFlow(int n)
+{
+	Coordinates c;
+	bool ok = BenchFlowGraph("Uniform random graph", RandomSparseGraph(n, 6, 100, 16));
+	ok = BenchFlowGraph("Geometric graph", RandomGeometricGraph(n, 17, c)) && ok;
+	return BenchFlowGraph("Cut with parallel edges", RandomSparseGraph(20000, 6, 100, 16)) && ok;
+}
+
+// BenchMinCost() - times both minimum cost flow methods sending amount
+// (or as much as fits) across a geometric graph from its left edge to its
+// right edge, and checks they agree on the cost. A source joined to every
+// node near the left edge and a sink joined from every node near the
+// right edge are added. Capacities run from 1 to 20, unlimited on the
+// added edges, so that many routes are needed.
+inline bool BenchMinCost(int n, int64_t amount)
+{
+	Coordinates c;
+	CsrGraph g = RandomGeometricGraph(n, 18, c);
+	double side = std::sqrt((double) n);
+	int s = n, t = n + 1;
+	std::vector<size_t> offsets(n + 3, 0);
+	std::vector<Edge> edges;
+
+	for (int u = 0; u < n; u++)
+	{
+		for (auto e : g.OutEdges(u))
+			edges.push_back(e);
+		if (c.x[u] > side * 0.95)
+			edges.push_back(Edge{ t, 0 });
+		offsets[u + 1] = edges.size();
+	}
+	for (int u = 0; u < n; u++)
+		if (c.x[u] < side * 0.05)
+			edges.push_back(Edge{ u, 0 });
+	offsets[n + 1] = offsets[n + 2] = edges.size();
+	CsrGraph network(std::move(offsets), std::move(edges));
+
+	auto capacity = [n](int u, Edge e) { return u >= n || e.to >= n ? 1000000 : 1 + (u * 7 + e.to * 13) % 20; };
+	int64_t sent = 0, ssp_cost = 0, scaling_cost = 0;
+	bool carried = false;
+
+	std::cout << "Geometric graph: " << n << " nodes, " << g.EdgeCount() << " edges" << std::endl;
+	MinCostFlow flow(network, capacity);
+	BenchReport("  successive shortest paths", TimeIt([&]()
+	{
+		sent = flow.SuccessiveShortestPaths(s, t, amount, ssp_cost);
+	}));
+	int searches = flow.Searches();
+	BenchReport("  cost scaling", TimeIt([&]()
+	{
+		carried = flow.CostScaling(s, t, sent, scaling_cost);
+	}));
+	std::cout << "  sent " << sent << " at cost " << ssp_cost << " using " << searches;
+	std::cout << " searches" << std::endl;
+	if (!carried || ssp_cost != scaling_cost)
+	{
+		std::cerr << "The two methods disagree." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// BenchDense() - times FloydWarshall() in each semiring with the plain
+// and the SSE2 rows, and reachability as bytes and as bits. Shortest and
+// widest results are checked against PathSearch() from a few sources and
+// the two forms of reachability against each other.
+inline bool BenchDense(int n)
+{
+	std::vector<int> dense = RandomDenseMatrix(n, 0.05, 100, 19);
+	DenseView g(dense, n);
+	std::vector<int> d, prev;
+	bool ok = true;
+
+	std::cout << "Dense graph: " << n << " nodes" << std::endl;
+	std::vector<int> plain = DenseMatrix<MinPlus>(g);
+	std::vector<int> simd = plain;
+	BenchReport("  min-plus, plain", TimeIt([&]() { FloydWarshall<MinPlus>(plain, n, false); }));
+	BenchReport("  min-plus, SSE2", TimeIt([&]() { FloydWarshall<MinPlus>(simd, n); }));
+	ok = ok && plain == simd;
+	for (int s = 0; s < n; s += std::max(1, n / 5))
+	{
+		PathSearch<ShortestPath>(g, s, d, prev);
+		for (int v = 0; v < n; v++)
+			ok = ok && simd[(size_t) s * n + v] == (d[v] == INT_MAX ? MinPlus::Zero() : d[v]);
+	}
+
+	plain = DenseMatrix<MaxMin>(g);
+	simd = plain;
+	BenchReport("  max-min, plain", TimeIt([&]() { FloydWarshall<MaxMin>(plain, n, false); }));
+	BenchReport("  max-min, SSE2", TimeIt([&]() { FloydWarshall<MaxMin>(simd, n); }));
+	ok = ok && plain == simd;
+	for (int s = 0; s < n; s += std::max(1, n / 5))
+	{
+		PathSearch<WidestPath>(g, s, d, prev);
+		for (int v = 0; v < n; v++)
+			ok = ok && simd[(size_t) s * n + v] == d[v];
+	}
+
+	// A sparse directed graph, so that reachability is not all or nothing.
+	std::mt19937 rng(20);
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		for (int i = 0; i < 2; i++)
+			edges.push_back(Edge{ (int) (rng() % n), 1 });
+		offsets[u + 1] = edges.size();
+	}
+	CsrGraph directed(std::move(offsets), std::move(edges));
+	std::vector<uint8_t> bytes = DenseMatrix<BoolOrAnd>(directed);
+	std::vector<uint8_t> bytes_simd = bytes;
+	BitMatrix bits;
+	BenchReport("  reach, bytes, plain", TimeIt([&]() { FloydWarshall<BoolOrAnd>(bytes, n, false); }));
+	BenchReport("  reach, bytes, SSE2", TimeIt([&]() { FloydWarshall<BoolOrAnd>(bytes_simd, n); }));
+	BenchReport("  reach, bits", TimeIt([&]() { bits = ReachabilityMatrix(directed); }));
+	std::cout << "  reachability takes " << bytes.size() << " bytes as bytes, " << bits.Bytes();
+	std::cout << " as bits" << std::endl;
+	ok = ok && bytes == bytes_simd;
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++)
+			ok = ok && bits.Get(i, j) == (bytes[(size_t) i * n + j] != 0);
+
+	if (!ok)
+		std::cerr << "Dense results differ." << std::endl;
+	return ok;
+}
+
+// BenchReach() - times reachability queries answered by the index and by
+// a breadth first search that stops when it finds t, on a directed graph
+// whose edges mostly run from lower to higher numbered nodes with a few
+// running back, so that there are cycles but many pairs are unreachable.
+inline bool BenchReach(int n, int queries)
+{
+	std::mt19937 rng(21);
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			int v = u + 1 + (int) (rng() % 1000);
+			if (rng() % 100 == 0)
+				v = u - 1 - (int) (rng() % 50);
+			if (v >= 0 && v < n)
+				edges.push_back(Edge{ v, 1 });
+		}
+		offsets[u + 1] = edges.size();
+	}
+	CsrGraph g(std::move(offsets), std::move(edges));
+
+	std::vector<std::pair<int, int>> pairs(queries);
+	for (auto & q : pairs)
+	{
+		q.first = (int) (rng() % n);
+		q.second = (int) (rng() % n);
+	}
+	std::cout << "Directed graph: " << n << " nodes, " << g.EdgeCount() << " edges, ";
+	std::cout << queries << " queries" << std::endl;
+
+	ReachabilityIndex index;
+	BenchReport("  build index", TimeIt([&]() { index.Build(g); }));
+	std::cout << "  " << index.Components() << " components, " << index.Bytes() << " bytes" << std::endl;
+
+	std::vector<char> by_index(queries), by_search(queries);
+	BenchReport("  queries by index", TimeIt([&]()
+	{
+		for (int i = 0; i < queries; i++)
+			by_index[i] = index.Reaches(pairs[i].first, pairs[i].second);
+	}));
+
+	// The search is far slower, so it answers only the first thousand.
+	int searched = std::min(queries, 1000);
+	std::vector<int> seen(n, -1);
+	std::vector<int> frontier;
+	BenchReport("  " + std::to_string(searched) + " queries by search", TimeIt([&]()
+	{
+		for (int i = 0; i < searched; i++)
+		{
+			auto [s, t] = pairs[i];
+			bool found = s == t;
+			frontier.assign(1, s);
+			seen[s] = i;
+			for (size_t f = 0; f < frontier.size() && !found; f++)
+			{
+				for (auto e : g.OutEdges(frontier[f]))
+				{
+					found = found || e.to == t;
+					if (seen[e.to] != i)
+					{
+						seen[e.to] = i;
+						frontier.push_back(e.to);
+					}
+				}
+			}
+			by_search[i] = found;
+		}
+	}));
+
+	int reachable = 0;
+	for (int i = 0; i < queries; i++)
+		reachable += by_index[i];
+	std::cout << "  " << reachable << " reachable, " << index.Searches() << " needed a search of the DAG" << std::endl;
+	if (!std::equal(by_search.begin(), by_search.begin() + searched, by_index.begin()))
+	{
+		std::cerr << "The index and the search disagree." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// BenchNextHop() - builds next hop tables (see NextHop.h) on a graph where
+// a third of the edges weigh nothing, so that equally cheap routes and
+// zero weight cycles abound. One table is built from dijkstra()'s previous
+// nodes and one from ShortestFewestEdges. Every route of the second must
+// arrive at the least cost. The first is only reported: the number of its
+// routes that went around in a circle.
+inline bool BenchNextHop(int n, int threads)
+{
+	CsrGraph sparse = RandomSparseGraph(n, 4, 3, 8);
+	std::vector<size_t> offsets(n + 1, 0);
+	std::vector<Edge> edges;
+	for (int u = 0; u < n; u++)
+	{
+		for (auto e : sparse.OutEdges(u))
+			edges.push_back(Edge{ e.to, e.weight - 1 });
+		offsets[u + 1] = edges.size();
+	}
+	CsrGraph g(std::move(offsets), std::move(edges));
+	std::vector<int> dist((size_t) n * n);
+	NextHopTable plain, fewest;
+	std::cout << n << " nodes, " << g.EdgeCount() << " edges, weights 0 to 2" << std::endl;
+
+	BenchReport("  table from dijkstra()", TimeIt([&]()
+	{
+		plain.Init(g);
+		ParallelApsp(g, threads, [&](int s, const std::vector<int> &, const std::vector<int> & prev)
+		{
+			plain.AddRow(s, prev);
+		});
+		plain.Finish();
+	}));
+	BenchReport("  table from ShortestFewestEdges", TimeIt([&]()
+	{
+		fewest.Init(g);
+		ParallelApsp<ShortestFewestEdges>(g, threads, [&](int s, const std::vector<int> & d, const std::vector<int> & prev)
+		{
+			std::copy(d.begin(), d.end(), dist.begin() + (size_t) s * n);
+			fewest.AddRow(s, prev);
+		});
+		fewest.Finish();
+	}));
+
+	// route_cost() - the cost of a route, taking the cheapest edge between
+	// each pair of nodes along it.
+	auto route_cost = [&](const std::vector<int> & route)
+	{
+		int cost = 0;
+		for (size_t i = 0; i + 1 < route.size(); i++)
+		{
+			int cheapest = INT_MAX;
+			for (auto e : g.OutEdges(route[i]))
+				if (e.to == route[i + 1])
+					cheapest = std::min(cheapest, e.weight);
+			cost += cheapest;
+		}
+		return cost;
+	};
+
+	// Routes that circle take n steps to give up on, so only about two
+	// hundred sources are checked, against every target.
+	std::vector<int> route;
+	int64_t circles = 0;
+	int64_t wrong = 0;
+	for (int s = 0; s < n; s += std::max(1, n / 200))
+	{
+		for (int t = 0; t < n; t++)
+		{
+			int d = dist[(size_t) s * n + t];
+			plain.Route(s, t, route);
+			circles += route.empty() && d != INT_MAX;
+			fewest.Route(s, t, route);
+			if (route.empty() ? d != INT_MAX : route_cost(route) != d)
+				wrong++;
+		}
+	}
+	std::cout << "  routes from dijkstra()'s table that circled: " << circles << std::endl;
+	std::cout << "  routes from ShortestFewestEdges's table that were wrong: " << wrong << std::endl;
+	if (wrong > 0)
+	{
+		std::cerr << "The next hop table gave a route that was not least cost." << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,586 @@
+// Reading Graph Files
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Graph files are read through a ByteSource, which hands out the bytes of
+// the file a large chunk at a time, and a TextIntReader, which pulls the
+// numbers out of those chunks. OpenByteSource() looks at the first bytes
+// of a file and picks the right source, so compressed files are read
+// exactly like plain ones:
+//
+//	gzip	decompressed by zlib on its own thread, one chunk ahead of the
+//			reader, so decompressing and parsing overlap.
+//	zstd	a file made of several independent frames (as written by
+//			pzstd, or by concatenating separately compressed pieces) has
+//			its frames decompressed in parallel, each thread taking the
+//			next frame. A file holding a single frame is decompressed on
+//			its own thread, as gzip is.
+//
+// Compression support is chosen when building:
+//
+//	-DUSE_ZLIB and -lz		for gzip
+//	-DUSE_ZSTD and -lzstd	for zstd
+//
+// Without them a compressed file is refused with a message saying which
+// option is missing.
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+// ByteSource - anything text can be read from in chunks.
+class ByteSource
+{
+public:
+	virtual ~ByteSource()
+	{
+	}
+
+	// Read() - copies up to size bytes into buffer. Returns the number of
+	// bytes copied, 0 at the end of the input or on an error.
+	virtual size_t Read(char * buffer, size_t size) = 0;
+
+	// Failed() - once Read() has returned 0, true if that was because of
+	// an error (a damaged or truncated compressed file) rather than the
+	// end of the input.
+	virtual bool Failed() const
+	{
+		return false;
+	}
+};
+
+// FileSource - the bytes of an ordinary file.
+class FileSource : public ByteSource
+{
+public:
+	~FileSource()
+	{
+		if (f != nullptr)
+			fclose(f);
+	}
+
+	bool Open(const std::string & path)
+	{
+		f = fopen(path.c_str(), "rb");
+		return f != nullptr;
+	}
+
+	size_t Read(char * buffer, size_t size) override
+	{
+		return fread(buffer, 1, size, f);
+	}
+
+private:
+	FILE * f = nullptr;
+};
+
+// ReadAheadSource - runs another source on a thread of its own, keeping a
+// few blocks ready ahead of the reader. Whatever work the other source
+// does (decompression) then overlaps whatever the reader does (parsing).
+class ReadAheadSource : public ByteSource
+{
+public:
+	explicit ReadAheadSource(std::unique_ptr<ByteSource> inner, size_t block = 1 << 20, size_t depth = 4) :
+		inner(std::move(inner)), block(block), depth(depth)
+	{
+		producer = std::thread(&ReadAheadSource::Produce, this);
+	}
+
+	~ReadAheadSource()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		space.notify_all();
+		producer.join();
+	}
+
+	size_t Read(char * buffer, size_t size) override
+	{
+		if (at == current.size())
+		{
+			if (finished)
+				return 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [&]() { return !blocks.empty(); });
+			current.swap(blocks.front());
+			blocks.pop_front();
+			lock.unlock();
+			space.notify_one();
+			at = 0;
+			if (current.empty())
+			{
+				finished = true;
+				inner_failed = inner->Failed();
+				return 0;
+			}
+		}
+		size_t n = std::min(size, current.size() - at);
+		memcpy(buffer, current.data() + at, n);
+		at += n;
+		return n;
+	}
+
+	bool Failed() const override
+	{
+		return inner_failed;
+	}
+
+private:
+	// Produce() - the read ahead thread. An empty block marks the end.
+	void Produce()
+	{
+		while (true)
+		{
+			std::vector<char> b(block);
+			b.resize(inner->Read(b.data(), b.size()));
+			bool last = b.empty();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				space.wait(lock, [&]() { return stop || blocks.size() < depth; });
+				if (stop)
+					return;
+				blocks.push_back(std::move(b));
+			}
+			ready.notify_one();
+			if (last)
+				return;
+		}
+	}
+
+	std::unique_ptr<ByteSource> inner;
+	size_t block;
+	size_t depth;
+	std::deque<std::vector<char>> blocks;
+	std::vector<char> current;
+	size_t at = 0;
+	bool finished = false;
+	bool inner_failed = false;
+	bool stop = false;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable space;
+	std::thread producer;
+};
+
+// MappedFile - a whole file mapped read only.
+class MappedFile
+{
+public:
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+	MappedFile() = default;
+
+	~MappedFile()
+	{
+		if (base != nullptr)
+			munmap((void *) base, size);
+	}
+
+	bool Open(const std::string & path)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+		if (ok)
+		{
+			void * p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			ok = p != MAP_FAILED;
+			if (ok)
+			{
+				base = (const char *) p;
+				size = st.st_size;
+				madvise(p, size, MADV_SEQUENTIAL);
+			}
+		}
+		close(fd);
+		return ok;
+	}
+
+	const char * base = nullptr;
+	size_t size = 0;
+};
+
+#ifdef USE_ZLIB
+// GzipSource - a gzip file. zlib reads any number of concatenated members.
+class GzipSource : public ByteSource
+{
+public:
+	~GzipSource()
+	{
+		if (f != nullptr)
+			gzclose(f);
+	}
+
+	bool Open(const std::string & path)
+	{
+		f = gzopen(path.c_str(), "rb");
+		if (f != nullptr)
+			gzbuffer(f, 1 << 20);
+		return f != nullptr;
+	}
+
+	size_t Read(char * buffer, size_t size) override
+	{
+		int n = gzread(f, buffer, (unsigned) std::min<size_t>(size, INT_MAX));
+		return n > 0 ? n : 0;
+	}
+
+private:
+	gzFile f = nullptr;
+};
+#endif
+
+#ifdef USE_ZSTD
+// ZstdStreamSource - a zstd file decompressed in order, frame after frame.
+class ZstdStreamSource : public ByteSource
+{
+public:
+	explicit ZstdStreamSource(std::unique_ptr<MappedFile> file) : file(std::move(file))
+	{
+		stream = ZSTD_createDStream();
+		input = ZSTD_inBuffer{ this->file->base, this->file->size, 0 };
+	}
+
+	~ZstdStreamSource()
+	{
+		ZSTD_freeDStream(stream);
+	}
+
+	// Read() - decompresses until buffer is full or the decoder stops
+	// making progress. The decoder may still hold output after the last
+	// input is consumed, so running out of input is not the test.
+	size_t Read(char * buffer, size_t size) override
+	{
+		ZSTD_outBuffer output{ buffer, size, 0 };
+		while (output.pos < output.size && !failed)
+		{
+			size_t in_before = input.pos;
+			size_t out_before = output.pos;
+			size_t r = ZSTD_decompressStream(stream, &output, &input);
+			if (ZSTD_isError(r))
+				failed = true;
+			if (input.pos == in_before && output.pos == out_before)
+				break;
+			remaining = r;
+		}
+		// Out of input with room left to write: this is the end. The last
+		// frame is complete only if the last call that made progress
+		// returned 0. (A call after a complete frame returns the size of
+		// the next frame's header, which is not there.)
+		if (output.pos < output.size && input.pos == input.size && remaining != 0)
+			failed = true;
+		return output.pos;
+	}
+
+	bool Failed() const override
+	{
+		return failed;
+	}
+
+private:
+	std::unique_ptr<MappedFile> file;
+	ZSTD_DStream * stream;
+	ZSTD_inBuffer input;
+	size_t remaining = 0;
+	bool failed = false;
+};
+
+// ZstdFramesSource - a zstd file of independent frames decompressed by
+// several threads. Each thread takes the next frame not yet taken. The
+// reader takes the decompressed frames in order. Threads get at most a
+// few frames ahead of the reader so memory stays bounded.
+class ZstdFramesSource : public ByteSource
+{
+public:
+	ZstdFramesSource(std::unique_ptr<MappedFile> file, const std::vector<std::pair<size_t, size_t>> & frames, int threads) :
+		file(std::move(file)), frames(frames), outputs(frames.size()), done(frames.size(), 0)
+	{
+		window = 2 * threads;
+		for (int t = 0; t < threads; t++)
+			workers.push_back(std::thread(&ZstdFramesSource::Work, this));
+	}
+
+	~ZstdFramesSource()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		space.notify_all();
+		for (auto & w : workers)
+			w.join();
+	}
+
+	size_t Read(char * buffer, size_t size) override
+	{
+		while (at == current.size())
+		{
+			if (next_out == frames.size())
+				return 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [&]() { return done[next_out] || failed; });
+			if (failed)
+				return 0;
+			current.swap(outputs[next_out]);
+			std::vector<char>().swap(outputs[next_out]);
+			next_out++;
+			lock.unlock();
+			space.notify_all();
+			at = 0;
+		}
+		size_t n = std::min(size, current.size() - at);
+		memcpy(buffer, current.data() + at, n);
+		at += n;
+		return n;
+	}
+
+	bool Failed() const override
+	{
+		return failed;
+	}
+
+private:
+	void Work()
+	{
+		ZSTD_DCtx * context = ZSTD_createDCtx();
+		while (true)
+		{
+			size_t f;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				space.wait(lock, [&]() { return stop || failed || next_in == frames.size() || next_in < next_out + window; });
+				if (stop || failed || next_in == frames.size())
+					break;
+				f = next_in++;
+			}
+			std::vector<char> out;
+			bool ok = Decompress(context, frames[f], out);
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				outputs[f].swap(out);
+				done[f] = 1;
+				failed = failed || !ok;
+			}
+			ready.notify_all();
+			if (!ok)
+				space.notify_all();
+		}
+		ZSTD_freeDCtx(context);
+	}
+
+	// Decompress() - one frame. When the frame records its size the output
+	// is decompressed in one call, otherwise it is streamed.
+	bool Decompress(ZSTD_DCtx * context, std::pair<size_t, size_t> frame, std::vector<char> & out)
+	{
+		const char * in = file->base + frame.first;
+		unsigned long long known = ZSTD_getFrameContentSize(in, frame.second);
+		if (known != ZSTD_CONTENTSIZE_UNKNOWN && known != ZSTD_CONTENTSIZE_ERROR)
+		{
+			out.resize(known);
+			size_t n = ZSTD_decompressDCtx(context, out.data(), out.size(), in, frame.second);
+			return !ZSTD_isError(n) && n == known;
+		}
+
+		// As in ZstdStreamSource::Read(), output is drained until the
+		// decoder stops making progress, and the last call that made
+		// progress must report the frame complete.
+		ZSTD_DCtx_reset(context, ZSTD_reset_session_only);
+		ZSTD_inBuffer input{ in, frame.second, 0 };
+		size_t remaining = 1;
+		while (true)
+		{
+			size_t used = out.size();
+			size_t in_before = input.pos;
+			out.resize(used + (1 << 20));
+			ZSTD_outBuffer output{ out.data() + used, 1 << 20, 0 };
+			size_t r = ZSTD_decompressStream(context, &output, &input);
+			out.resize(used + output.pos);
+			if (ZSTD_isError(r))
+				return false;
+			if (input.pos == in_before && output.pos == 0)
+				break;
+			remaining = r;
+		}
+		return remaining == 0;
+	}
+
+	std::unique_ptr<MappedFile> file;
+	std::vector<std::pair<size_t, size_t>> frames;
+	std::vector<std::vector<char>> outputs;
+	std::vector<char> done;
+	size_t window;
+	size_t next_in = 0;
+	size_t next_out = 0;
+	bool failed = false;
+	bool stop = false;
+	std::vector<char> current;
+	size_t at = 0;
+	std::mutex mutex;
+	std::condition_variable ready;
+	std::condition_variable space;
+	std::vector<std::thread> workers;
+};
+#endif
+
+// OpenByteSource() - opens a graph file, compressed or not.
+//
+// Parameters:
+//	const std::string & path	- the file.
+//	std::string * problem		- if not null, receives the reason the file
+//								  could not be opened.
+// Returns:
+//	std::unique_ptr<ByteSource>	- the source, or null on failure.
+inline std::unique_ptr<ByteSource> OpenByteSource(const std::string & path, std::string * problem = nullptr)
+{
+	unsigned char magic[4] = { 0, 0, 0, 0 };
+	FILE * f = fopen(path.c_str(), "rb");
+	if (f == nullptr)
+	{
+		if (problem)
+			*problem = "could not open " + path;
+		return nullptr;
+	}
+	size_t got = fread(magic, 1, sizeof(magic), f);
+	fclose(f);
+
+	bool gzip = got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+	bool zstd = got == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd;
+
+	if (gzip)
+	{
+#ifdef USE_ZLIB
+		std::unique_ptr<GzipSource> source(new GzipSource);
+		if (source->Open(path))
+			return std::unique_ptr<ByteSource>(new ReadAheadSource(std::move(source)));
+		if (problem)
+			*problem = "could not open " + path;
+#else
+		if (problem)
+			*problem = path + " is gzip compressed; build with -DUSE_ZLIB -lz to read it";
+#endif
+		return nullptr;
+	}
+	if (zstd)
+	{
+#ifdef USE_ZSTD
+		std::unique_ptr<MappedFile> file(new MappedFile);
+		std::vector<std::pair<size_t, size_t>> frames;
+		if (file->Open(path))
+		{
+			for (size_t at = 0; at < file->size; )
+			{
+				size_t n = ZSTD_findFrameCompressedSize(file->base + at, file->size - at);
+				if (ZSTD_isError(n))
+				{
+					if (problem)
+						*problem = path + " is not a well formed zstd file";
+					return nullptr;
+				}
+				frames.push_back(std::make_pair(at, n));
+				at += n;
+			}
+			int threads = (int) std::min<size_t>(frames.size(), std::max(1u, std::thread::hardware_concurrency()));
+			if (frames.size() > 1 && threads > 1)
+				return std::unique_ptr<ByteSource>(new ZstdFramesSource(std::move(file), frames, threads));
+			std::unique_ptr<ByteSource> stream(new ZstdStreamSource(std::move(file)));
+			return std::unique_ptr<ByteSource>(new ReadAheadSource(std::move(stream)));
+		}
+		if (problem)
+			*problem = "could not open " + path;
+#else
+		if (problem)
+			*problem = path + " is zstd compressed; build with -DUSE_ZSTD -lzstd to read it";
+#endif
+		return nullptr;
+	}
+
+	std::unique_ptr<FileSource> source(new FileSource);
+	if (!source->Open(path))
+	{
+		if (problem)
+			*problem = "could not open " + path;
+		return nullptr;
+	}
+	return source;
+}
+
+// TextIntReader - pulls whitespace separated integers out of a ByteSource
+// a large chunk at a time. This is many times faster than operator>>.
+class TextIntReader
+{
+public:
+	explicit TextIntReader(ByteSource & source) : source(source), buffer(1 << 20)
+	{
+	}
+
+	// Next() - reads the next integer. Returns false at the end of the
+	// input or if the next thing is not an integer that fits in an int.
+	bool Next(int & v)
+	{
+		int c;
+		while ((c = Peek()) != EOF && (c == ' ' || (c >= '\t' && c <= '\r')))
+			at++;
+		bool negative = c == '-';
+		if (c == '-' || c == '+')
+			at++;
+		if ((c = Peek()) < '0' || c > '9')
+			return false;
+		long long value = 0;
+		while ((c = Peek()) >= '0' && c <= '9')
+		{
+			value = value * 10 + (c - '0');
+			if (value > INT_MAX)
+				return false;
+			at++;
+		}
+		v = (int) (negative ? -value : value);
+		return true;
+	}
+
+private:
+	int Peek()
+	{
+		if (at == end)
+		{
+			at = 0;
+			end = source.Read(buffer.data(), buffer.size());
+			if (end == 0)
+				return EOF;
+		}
+		return (unsigned char) buffer[at];
+	}
+
+	ByteSource & source;
+	std::vector<char> buffer;
+	size_t at = 0;
+	size_t end = 0;
+};
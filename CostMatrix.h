@@ -0,0 +1,182 @@
+// Many to Many Cost Matrix
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Vehicle routing and travelling salesman solvers want the cost between
+// every pair of a set of points (customers, depots) rather than between
+// every pair of nodes. The matrix is built one row at a time: a search
+// from each point that stops as soon as every point it still needs has
+// been settled.
+//
+// The README promises that the graph is symmetric: the cost from u to v
+// is the cost from v to u. Then the matrix is symmetric too and only the
+// upper triangle needs to be searched. The search from point i needs only
+// points i + 1 onwards, the rest having been found by earlier searches
+// (the search from j < i found the cost from j to i, which is the same).
+// The last search is not needed at all and each one before it may stop
+// sooner. How much sooner depends on where the points lie: a search must
+// still reach the farthest point it needs, so on points scattered over a
+// whole map the saving in nodes settled is modest even though half the
+// matrix is never searched for. IsSymmetric() checks the promise before
+// relying on it.
+//
+// The searches share nothing but the finished matrix, so they are handed
+// out to several threads as ParallelApsp() does.
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#include "GraphView.h"
+#include "TiledMatrix.h"
+
+// IsSymmetric() - true if every edge u to v is matched by an edge v to u
+// of the same weight.
+template <GraphView G>
+bool IsSymmetric(const G & g)
+{
+	for (int u = 0; u < g.NodeCount(); u++)
+	{
+		for (auto e : g.OutEdges(u))
+		{
+			bool matched = false;
+			for (auto back : g.OutEdges(e.to))
+				matched = matched || (back.to == u && back.weight == e.weight);
+			if (!matched)
+				return false;
+		}
+	}
+	return true;
+}
+
+// DijkstraToTargets() - dijkstra() from s stopping once needed targets
+// have been settled. target[v] is true for the nodes wanted. Like
+// PrunedDijkstra() the caller keeps dist filled with INT_MAX between
+// calls and this resets only the entries it touched. Each settled
+// target is passed to found(v, cost).
+//
+// Returns:
+//	size_t		- the number of nodes settled.
+template <GraphView G, typename F>
+size_t DijkstraToTargets(const G & g, int s, const std::vector<char> & target, int needed,
+	std::vector<int> & dist, std::vector<int> & touched, F found)
+{
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+	size_t settled = 0;
+
+	touched.clear();
+	dist[s] = 0;
+	touched.push_back(s);
+	q.push(Entry(0, s));
+	while (!q.empty() && needed > 0)
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+		settled++;
+		if (target[u])
+		{
+			found(u, e.first);
+			needed--;
+		}
+		for (auto edge : g.OutEdges(u))
+		{
+			int newDist = e.first + edge.weight;
+			if (newDist < dist[edge.to])
+			{
+				if (dist[edge.to] == INT_MAX)
+					touched.push_back(edge.to);
+				dist[edge.to] = newDist;
+				q.push(Entry(newDist, edge.to));
+			}
+		}
+	}
+	for (int v : touched)
+		dist[v] = INT_MAX;
+	return settled;
+}
+
+// CostMatrix() - the cost between every pair of points.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::vector<int> & points	- the points (distinct nodes).
+//	bool symmetric				- search only the upper triangle. Only
+//								  correct if IsSymmetric(g).
+//	int threads					- how many threads (0 means one per core).
+//	std::vector<int> & matrix	- receives the k by k costs, row major,
+//								  INT_MAX where there is no route.
+// Returns:
+//	size_t						- the number of nodes settled by all searches.
+template <GraphView G>
+size_t CostMatrix(const G & g, const std::vector<int> & points, bool symmetric, int threads, std::vector<int> & matrix)
+{
+	int n = g.NodeCount();
+	int k = (int) points.size();
+	std::vector<int> point_of(n, -1);
+	std::atomic<int> next(0);
+	std::atomic<size_t> settled(0);
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < k; i++)
+		point_of[points[i]] = i;
+	matrix.assign((size_t) k * k, INT_MAX);
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	auto work = [&]()
+	{
+		std::vector<int> dist(n, INT_MAX), touched;
+		std::vector<char> target(n, 0);
+		for (int i = next++; i < k; i = next++)
+		{
+			int first = symmetric ? i : 0;
+			for (int j = first; j < k; j++)
+				target[points[j]] = 1;
+			settled += DijkstraToTargets(g, points[i], target, k - first, dist, touched, [&](int v, int cost)
+			{
+				int j = point_of[v];
+				matrix[(size_t) i * k + j] = cost;
+				if (symmetric)
+					matrix[(size_t) j * k + i] = cost;
+			});
+			for (int j = first; j < k; j++)
+				target[points[j]] = 0;
+		}
+	};
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(work));
+	work();
+	for (auto & t : workers)
+		t.join();
+	return settled;
+}
+
+// WriteTiledCostMatrix() - writes a k by k matrix as a compressed tiled
+// matrix file (see TiledMatrix.h). A solver reading it can fetch any
+// entry, or a whole tile of nearby points, without reading the rest.
+inline bool WriteTiledCostMatrix(const std::string & path, const std::vector<int> & matrix, int k, int tile)
+{
+	TiledMatrixWriter writer;
+	if (!writer.Open(path, k, tile))
+		return false;
+	std::vector<int> row(k);
+	for (int i = 0; i < k; i++)
+	{
+		std::copy(matrix.begin() + (size_t) i * k, matrix.begin() + (size_t) (i + 1) * k, row.begin());
+		writer.AddRow(i, row);
+	}
+	return writer.Close();
+}
@@ -0,0 +1,159 @@
+// Dijkstra's Algorithm on Any Graph View
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// The demo's dijkstra() works on the global dense matrix and the global
+// dist and previous_node vectors. The version here works on any
+// GraphView (see GraphView.h) and on vectors owned by the caller so that
+// several searches can run at once on different threads.
+//
+// Cheapest is not the only kind of best route. The widest route is the
+// one whose narrowest edge is as wide as possible (edge weights read as
+// capacities). The most reliable route is the one most likely to get
+// through (weights read as percent chances of crossing). The minimax
+// route keeps its worst edge as small as possible. All of them are found
+// by the same search. What differs is the value of a route and how it
+// grows along an edge:
+//
+//					value of s	extend by edge w	better		unreachable
+//	ShortestPath	0			value + w			smaller		INT_MAX
+//	WidestPath		INT_MAX		min(value, w)		larger		0
+//	MostReliable	0			value - log(w/100)	smaller		infinity
+//	MinimaxPath		0			max(value, w)		smaller		INT_MAX
+//
+// Reliabilities multiply along a route. Adding their negative logarithms
+// instead turns the product into a sum of non-negative terms, which is
+// what the search needs and which does not lose precision on long routes.
+//
+// These are semirings, each supplied to PathSearch() as a template
+// argument. Each becomes its own search at compile time with nothing
+// decided while it runs. The search is correct for any of them because
+// extending a route by an edge never makes it better.
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+#include "GraphView.h"
+
+struct ShortestPath
+{
+	typedef int Value;
+	static Value Source() { return 0; }
+	static Value Unreachable() { return INT_MAX; }
+	static Value Extend(Value v, int w) { return v + w; }
+	static bool Better(Value a, Value b) { return a < b; }
+};
+
+// ShortestFewestEdges - the cheapest route and, among routes of equal
+// cost, the one with the fewest edges. Zero weight edges make ties common
+// and searches from different sources may otherwise break them in ways
+// that disagree (see NextHop.h). The cost is kept in the high 32 bits of
+// the value and the edge count in the low 32, so one comparison orders by
+// both.
+struct ShortestFewestEdges
+{
+	typedef int64_t Value;
+	static Value Source() { return 0; }
+	static Value Unreachable() { return INT64_MAX; }
+	static Value Extend(Value v, int w) { return v + ((int64_t) w << 32) + 1; }
+	static bool Better(Value a, Value b) { return a < b; }
+
+	// Cost() - the cost part of a value, INT_MAX if unreachable.
+	static int Cost(Value v) { return v == Unreachable() ? INT_MAX : (int) (v >> 32); }
+};
+
+struct WidestPath
+{
+	typedef int Value;
+	static Value Source() { return INT_MAX; }
+	static Value Unreachable() { return 0; }
+	static Value Extend(Value v, int w) { return std::min(v, w); }
+	static bool Better(Value a, Value b) { return a > b; }
+};
+
+// MostReliable - values are -log(chance of getting through). Weights
+// over 100 are taken as certain.
+struct MostReliable
+{
+	typedef double Value;
+	static Value Source() { return 0; }
+	static Value Unreachable() { return INFINITY; }
+	static Value Extend(Value v, int w) { return v - std::log(std::min(w, 100) / 100.0); }
+	static bool Better(Value a, Value b) { return a < b; }
+
+	// Chance() - converts a value back to a chance between 0 and 1.
+	static double Chance(Value v) { return std::exp(-v); }
+};
+
+struct MinimaxPath
+{
+	typedef int Value;
+	static Value Source() { return 0; }
+	static Value Unreachable() { return INT_MAX; }
+	static Value Extend(Value v, int w) { return std::max(v, w); }
+	static bool Better(Value a, Value b) { return a < b; }
+};
+
+// PathSearch() - a heap of (value, node) pairs stands in for the demo's
+// set. The set needs a node erased and re-inserted when its cost drops.
+// The heap instead gets a second, better entry for the node and the old
+// entry is recognized as stale and skipped when it is eventually popped.
+//
+// Parameters:
+//	const G & g				- the graph.
+//	int s					- the source node.
+//	std::vector<...> & dist	- receives the value of the best route to
+//							  every node.
+//	std::vector<int> & prev	- receives the previous node on each route.
+// Returns:
+//	none
+template <typename S, GraphView G>
+void PathSearch(const G & g, int s, std::vector<typename S::Value> & dist, std::vector<int> & prev)
+{
+	typedef typename S::Value Value;
+	typedef std::pair<Value, int> Entry;
+	auto worse = [](const Entry & a, const Entry & b) { return S::Better(b.first, a.first); };
+	std::priority_queue<Entry, std::vector<Entry>, decltype(worse)> q(worse);
+
+	dist.assign(g.NodeCount(), S::Unreachable());
+	prev.assign(g.NodeCount(), -1);
+	dist[s] = S::Source();
+	q.push(Entry(dist[s], s));
+
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+
+		for (auto edge : g.OutEdges(u))
+		{
+			Value extended = S::Extend(e.first, edge.weight);
+			if (S::Better(extended, dist[edge.to]))
+			{
+				dist[edge.to] = extended;
+				prev[edge.to] = u;
+				q.push(Entry(extended, edge.to));
+			}
+		}
+	}
+}
+
+// DijkstraFrom() - PathSearch() for the cheapest routes.
+template <GraphView G>
+void DijkstraFrom(const G & g, int s, std::vector<int> & dist, std::vector<int> & prev)
+{
+	PathSearch<ShortestPath>(g, s, dist, prev);
+}
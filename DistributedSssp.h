@@ -0,0 +1,433 @@
+// Distributed Single Source Shortest Paths
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// A graph too big for one machine must be split across several. Here the
+// nodes are split into ranges, one range per worker process, each worker
+// holding only the edges that leave its own nodes. The workers talk over
+// Unix domain sockets, so the whole arrangement can be tried out on one
+// machine. Replacing the sockets with TCP connections spreads it across
+// machines without changing the algorithm.
+//
+// The search proceeds in rounds:
+//
+//	1. Each worker runs an ordinary dijkstra() over its own nodes, starting
+//	   from whatever nodes improved since the last round, until its queue
+//	   is empty. An edge leading to another worker's node cannot be
+//	   followed. Instead the best cost found for that node is set aside.
+//	2. Each worker sends every other worker one batch holding all the
+//	   costs it set aside for that worker's nodes (possibly none).
+//	3. Each worker receives one batch from every other worker and applies
+//	   the improvements. Improved nodes start the next round.
+//	4. Each worker tells the coordinator (the parent process) how many
+//	   costs it sent. If no worker sent anything, no worker has anything
+//	   left to do and the coordinator ends the search. Otherwise it starts
+//	   another round.
+//
+// Batching means one message per pair of workers per round however many
+// boundary edges there are, which is what keeps the network from being
+// the bottleneck.
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <climits>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "GraphView.h"
+
+struct DistributedStats
+{
+	int rounds = 0;
+	long long messages = 0;		// batches sent between workers
+	long long updates = 0;		// boundary costs carried by those batches
+};
+
+// WriteAll() - writes all of a buffer to a socket, however many calls it takes.
+inline bool WriteAll(int fd, const void * data, size_t size)
+{
+	const char * p = (const char *) data;
+	while (size > 0)
+	{
+		ssize_t n = write(fd, p, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+// ReadAll() - reads exactly size bytes from a socket.
+inline bool ReadAll(int fd, void * data, size_t size)
+{
+	char * p = (char *) data;
+	while (size > 0)
+	{
+		ssize_t n = read(fd, p, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+// One boundary cost: node v can be reached at cost via node prev.
+struct BoundaryUpdate
+{
+	int32_t node;
+	int32_t cost;
+	int32_t prev;
+};
+
+// DistributedWorker - everything one worker process knows: its own range
+// of nodes, their out edges, their costs, and sockets to the other
+// workers and to the coordinator.
+class DistributedWorker
+{
+public:
+	template <GraphView G>
+	DistributedWorker(const G & g, int rank, const std::vector<int> & first_node) :
+		rank(rank), first_node(first_node)
+	{
+		first = first_node[rank];
+		last = first_node[rank + 1];
+
+		// Keep only the edges leaving this worker's nodes.
+		offsets.assign(last - first + 1, 0);
+		for (int u = first; u < last; u++)
+		{
+			for (auto e : g.OutEdges(u))
+				edges.push_back(Edge{ e.to, e.weight });
+			offsets[u - first + 1] = edges.size();
+		}
+		dist.assign(last - first, INT_MAX);
+		prev.assign(last - first, -1);
+	}
+
+	// Run() - takes part in rounds until the coordinator says to stop,
+	// then sends this worker's costs to the coordinator.
+	//
+	// Parameters:
+	//	int s							- the source node.
+	//	const std::vector<int> & peers	- socket to each other worker (-1 for self).
+	//	int coordinator					- socket to the coordinator.
+	// Returns:
+	//	bool							- false if any socket failed.
+	bool Run(int s, const std::vector<int> & peers, int coordinator)
+	{
+		int workers = (int) peers.size();
+
+		if (s >= first && s < last)
+		{
+			dist[s - first] = 0;
+			q.push(Entry(0, s));
+		}
+
+		// best[w] holds the boundary updates for worker w and index[w] the
+		// position of each of w's nodes within best[w]. index[w] is sized
+		// to w's whole range the first time it is needed and kept for
+		// every later round. Only the entries used by a round are reset,
+		// so a round costs what its boundary traffic costs.
+		std::vector<std::vector<BoundaryUpdate>> best(workers);
+		std::vector<std::vector<int>> index(workers);
+
+		while (true)
+		{
+			// 1. Local dijkstra(). Boundary costs are kept per node, only
+			// the best one survives to be sent.
+			LocalSearch([&](int v, int cost, int u)
+			{
+				int w = Owner(v);
+				std::vector<int> & at = index[w];
+				if (at.empty())
+					at.assign(first_node[w + 1] - first_node[w], -1);
+				int & i = at[v - first_node[w]];
+				if (i == -1)
+				{
+					i = (int) best[w].size();
+					best[w].push_back(BoundaryUpdate{ v, cost, u });
+				}
+				else if (cost < best[w][i].cost)
+					best[w][i] = BoundaryUpdate{ v, cost, u };
+			});
+
+			// 2 and 3. Send to every peer while receiving from every peer.
+			// Sending is done by a second thread so that two workers
+			// sending each other large batches cannot both block.
+			long long sent = 0;
+			bool ok = true;
+			std::thread sender([&]()
+			{
+				for (int w = 0; w < workers; w++)
+				{
+					if (w == rank)
+						continue;
+					uint64_t count = best[w].size();
+					ok = WriteAll(peers[w], &count, sizeof(count)) &&
+						WriteAll(peers[w], best[w].data(), count * sizeof(BoundaryUpdate)) && ok;
+					sent += count;
+				}
+			});
+			bool received = true;
+			std::vector<BoundaryUpdate> batch;
+			for (int w = 0; w < workers && received; w++)
+			{
+				if (w == rank)
+					continue;
+				uint64_t count;
+				// A peer sends at most one update per node of this worker,
+				// each for a node in this worker's range. Anything else, or
+				// a short read, means the stream is corrupt and the worker
+				// gives up before indexing with it.
+				received = ReadAll(peers[w], &count, sizeof(count)) && count <= (uint64_t) (last - first);
+				if (!received)
+					break;
+				batch.resize(count);
+				received = ReadAll(peers[w], batch.data(), count * sizeof(BoundaryUpdate));
+				if (!received)
+					break;
+				for (auto & b : batch)
+				{
+					if (b.node < first || b.node >= last)
+					{
+						received = false;
+						break;
+					}
+					if (b.cost < dist[b.node - first])
+					{
+						dist[b.node - first] = b.cost;
+						prev[b.node - first] = b.prev;
+						q.push(Entry(b.cost, b.node));
+					}
+				}
+			}
+			sender.join();
+			if (!ok || !received)
+				return false;
+			for (int w = 0; w < workers; w++)
+			{
+				for (auto & b : best[w])
+					index[w][b.node - first_node[w]] = -1;
+				best[w].clear();
+			}
+
+			// 4. Report and wait for the verdict.
+			int64_t report = sent;
+			char verdict;
+			if (!WriteAll(coordinator, &report, sizeof(report)) || !ReadAll(coordinator, &verdict, 1))
+				return false;
+			if (verdict == 0)
+				break;
+		}
+
+		return WriteAll(coordinator, dist.data(), dist.size() * sizeof(int)) &&
+			WriteAll(coordinator, prev.data(), prev.size() * sizeof(int));
+	}
+
+private:
+	typedef std::pair<int, int> Entry;
+
+	int Owner(int v) const
+	{
+		return (int) (std::upper_bound(first_node.begin(), first_node.end(), v) - first_node.begin()) - 1;
+	}
+
+	// LocalSearch() - dijkstra() confined to this worker's nodes. Edges
+	// leaving the range are handed to boundary instead.
+	void LocalSearch(const std::function<void(int v, int cost, int u)> & boundary)
+	{
+		while (!q.empty())
+		{
+			Entry e = q.top();
+			q.pop();
+			int u = e.second;
+			if (e.first != dist[u - first])
+				continue;
+			for (size_t i = offsets[u - first]; i < offsets[u - first + 1]; i++)
+			{
+				int v = edges[i].to;
+				int newDist = e.first + edges[i].weight;
+				if (v < first || v >= last)
+					boundary(v, newDist, u);
+				else if (newDist < dist[v - first])
+				{
+					dist[v - first] = newDist;
+					prev[v - first] = u;
+					q.push(Entry(newDist, v));
+				}
+			}
+		}
+	}
+
+	int rank;
+	int first;
+	int last;
+	std::vector<int> first_node;
+	std::vector<size_t> offsets;
+	std::vector<Edge> edges;
+	std::vector<int> dist;
+	std::vector<int> prev;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+};
+
+// DistributedSssp() - forks the given number of worker processes, each
+// taking a range of nodes with about the same number of edges, runs the
+// rounds described above and gathers the results.
+//
+// Parameters:
+//	const G & g				- the graph.
+//	int s					- the source node.
+//	int processes			- the number of worker processes.
+//	std::vector<int> & dist	- receives the cost to every node.
+//	std::vector<int> & prev	- receives the previous node on each route.
+//	DistributedStats * stats	- if not null, receives counts of the work done.
+// Returns:
+//	bool					- false if a process or socket could not be
+//							  created or a worker failed.
+template <GraphView G>
+bool DistributedSssp(const G & g, int s, int processes, std::vector<int> & dist, std::vector<int> & prev,
+	DistributedStats * stats = nullptr)
+{
+	int n = g.NodeCount();
+	processes = std::max(1, std::min(processes, n));
+
+	// Node ranges with roughly equal numbers of edges.
+	std::vector<size_t> degree_prefix(n + 1, 0);
+	for (int u = 0; u < n; u++)
+		degree_prefix[u + 1] = degree_prefix[u] + (size_t) std::ranges::distance(g.OutEdges(u));
+	std::vector<int> first_node(processes + 1, n);
+	first_node[0] = 0;
+	for (int w = 1; w < processes; w++)
+	{
+		int u = (int) (std::lower_bound(degree_prefix.begin(), degree_prefix.end(),
+			degree_prefix[n] * w / processes) - degree_prefix.begin());
+		first_node[w] = std::max(first_node[w - 1] + 1, std::min(u, n - (processes - w)));
+	}
+
+	// mesh[a][b] is a's end of the socket between workers a and b.
+	std::vector<std::vector<int>> mesh(processes, std::vector<int>(processes, -1));
+	std::vector<int> to_worker(processes, -1);
+	std::vector<int> to_coordinator(processes, -1);
+	std::vector<int> all_fds;
+	bool ok = true;
+
+	for (int a = 0; a < processes && ok; a++)
+	{
+		int fds[2];
+		ok = socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0;
+		if (ok)
+		{
+			to_worker[a] = fds[0];
+			to_coordinator[a] = fds[1];
+			all_fds.insert(all_fds.end(), fds, fds + 2);
+		}
+		for (int b = a + 1; b < processes && ok; b++)
+		{
+			ok = socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0;
+			if (ok)
+			{
+				mesh[a][b] = fds[0];
+				mesh[b][a] = fds[1];
+				all_fds.insert(all_fds.end(), fds, fds + 2);
+			}
+		}
+	}
+
+	std::vector<pid_t> children;
+	std::cout.flush();
+	std::cerr.flush();
+	for (int w = 0; w < processes && ok; w++)
+	{
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			ok = false;
+			break;
+		}
+		if (pid == 0)
+		{
+			// The worker keeps only its own sockets.
+			for (int fd : all_fds)
+			{
+				bool mine = fd == to_coordinator[w];
+				for (int b = 0; b < processes; b++)
+					mine = mine || fd == mesh[w][b];
+				if (!mine)
+					close(fd);
+			}
+			DistributedWorker worker(g, w, first_node);
+			bool worked = worker.Run(s, mesh[w], to_coordinator[w]);
+			_exit(worked ? 0 : 1);
+		}
+		children.push_back(pid);
+	}
+
+	// The coordinator only needs its end of each worker's socket.
+	for (int fd : all_fds)
+		if (std::find(to_worker.begin(), to_worker.end(), fd) == to_worker.end())
+			close(fd);
+
+	DistributedStats counts;
+	while (ok && (int) children.size() == processes)
+	{
+		long long total = 0;
+		for (int w = 0; w < processes && ok; w++)
+		{
+			int64_t sent;
+			ok = ReadAll(to_worker[w], &sent, sizeof(sent));
+			total += sent;
+		}
+		if (!ok)
+			break;
+		counts.rounds++;
+		counts.updates += total;
+		counts.messages += (long long) processes * (processes - 1);
+		char verdict = total > 0;
+		for (int w = 0; w < processes && ok; w++)
+			ok = WriteAll(to_worker[w], &verdict, 1);
+		if (!verdict)
+			break;
+	}
+
+	dist.assign(n, INT_MAX);
+	prev.assign(n, -1);
+	for (int w = 0; w < processes && ok && (int) children.size() == processes; w++)
+	{
+		int size = first_node[w + 1] - first_node[w];
+		ok = ReadAll(to_worker[w], dist.data() + first_node[w], size * sizeof(int)) &&
+			ReadAll(to_worker[w], prev.data() + first_node[w], size * sizeof(int));
+	}
+
+	for (int fd : to_worker)
+		if (fd != -1)
+			close(fd);
+	for (pid_t pid : children)
+	{
+		int status;
+		waitpid(pid, &status, 0);
+		ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+	if (stats)
+		*stats = counts;
+	return ok && (int) children.size() == processes;
+}
@@ -0,0 +1,353 @@
+// Facility Location Queries
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Given a set of candidate "facility" nodes (warehouses, fire stations,
+// whatever) these functions answer questions of the form:
+//
+//	- which facility is nearest to each node?
+//	- which nodes count a given facility among their k nearest?
+//	- where should p facilities go so the total cost of every node
+//	  reaching its nearest facility is small (the p-median problem)?
+//
+// All of these are variations on dijkstra(). The first two start the
+// search from many sources at once. The last one reuses the current
+// best distances as a fence so that placing a new facility only
+// explores the part of the graph it actually improves.
+
+#pragma once
+
+#include <vector>
+#include <set>
+#include <queue>
+#include <climits>
+#include <functional>
+#include <utility>
+
+#include "GraphView.h"
+
+// PrunedDijkstra() - dijkstra() with a fence. A node v is only updated if
+// its new cost is strictly less than limit[v]. Anything not improved is
+// never placed in the queue, so nothing beyond it is explored either.
+//
+// This is correct for facility location because limit[v] is the cost
+// from v to its nearest facility. If the new facility cannot beat that
+// at v, it cannot beat it at any node reached through v (the existing
+// facility gets there at least as cheaply by going through v too).
+//
+// The caller owns dist and must fill it with INT_MAX before the first
+// call. Only the entries listed in touched are changed by a call. The
+// caller resets just those entries to INT_MAX when done, making the
+// cost of a call proportional to the region explored rather than to
+// the size of the graph.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	int s						- the source node.
+//	const std::vector<int> & limit	- the fence described above.
+//	std::vector<int> & dist		- workspace of size n (see above).
+//	std::vector<int> & touched	- receives the nodes whose dist was set.
+// Returns:
+//	none
+template <GraphView G>
+void PrunedDijkstra(const G & g, int s,
+	const std::vector<int> & limit, std::vector<int> & dist, std::vector<int> & touched)
+{
+	touched.clear();
+	if (limit[s] <= 0)
+		return;
+
+	// The demo's set<int, ltDist> needs erase-then-insert to update a
+	// node. Here a heap of (cost, node) pairs is used instead. A stale
+	// entry is recognized when popped because its cost no longer matches
+	// dist and is simply skipped.
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+
+	dist[s] = 0;
+	touched.push_back(s);
+	q.push(Entry(0, s));
+
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+
+		for (auto e : g.OutEdges(u))
+		{
+			int v = e.to;
+			int newDist = dist[u] + e.weight;
+			if (newDist < dist[v] && newDist < limit[v])
+			{
+				if (dist[v] == INT_MAX)
+					touched.push_back(v);
+				dist[v] = newDist;
+				q.push(Entry(newDist, v));
+			}
+		}
+	}
+}
+
+// NearestFacility() - a single dijkstra() started from every facility at
+// once. Each node ends up with the cost to, and the identity of, the
+// facility closest to it. Nodes that cannot reach any facility are left
+// with a cost of INT_MAX and an owner of -1.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::vector<int> & facilities	- the facility nodes.
+//	std::vector<int> & dist		- receives the cost to the nearest facility.
+//	std::vector<int> & owner	- receives the nearest facility.
+// Returns:
+//	none
+template <GraphView G>
+void NearestFacility(const G & g, const std::vector<int> & facilities,
+	std::vector<int> & dist, std::vector<int> & owner)
+{
+	int n = g.NodeCount();
+	typedef std::pair<int, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+
+	dist.assign(n, INT_MAX);
+	owner.assign(n, -1);
+
+	// Ties between facilities are broken towards the one listed first.
+	for (int f : facilities)
+	{
+		if (dist[f] != 0)
+		{
+			dist[f] = 0;
+			owner[f] = f;
+			q.push(Entry(0, f));
+		}
+	}
+
+	while (!q.empty())
+	{
+		Entry e = q.top();
+		q.pop();
+		int u = e.second;
+		if (e.first != dist[u])
+			continue;
+
+		for (auto e : g.OutEdges(u))
+		{
+			int v = e.to;
+			int newDist = dist[u] + e.weight;
+			if (newDist < dist[v])
+			{
+				dist[v] = newDist;
+				owner[v] = owner[u];
+				q.push(Entry(newDist, v));
+			}
+		}
+	}
+}
+
+// KNearestFacilities() - like NearestFacility() but every node collects
+// up to k facilities in order of increasing cost. The search carries
+// (cost, node, facility) labels. A node stops accepting labels once it
+// has k of them and never accepts a second label from the same facility.
+// Each facility's labels form an ordinary dijkstra() so the first label a
+// node receives from a facility is its true cost.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::vector<int> & facilities	- the facility nodes.
+//	int k						- how many facilities each node keeps.
+//	std::vector<std::vector<std::pair<int, int>>> & nearest
+//								- receives, per node, (cost, facility) pairs
+//								  sorted by cost.
+// Returns:
+//	none
+template <GraphView G>
+void KNearestFacilities(const G & g, const std::vector<int> & facilities,
+	int k, std::vector<std::vector<std::pair<int, int>>> & nearest)
+{
+	int n = g.NodeCount();
+	struct Label
+	{
+		int cost;
+		int node;
+		int facility;
+		bool operator>(const Label & o) const
+		{
+			if (cost != o.cost)
+				return cost > o.cost;
+			if (facility != o.facility)
+				return facility > o.facility;
+			return node > o.node;
+		}
+	};
+	std::priority_queue<Label, std::vector<Label>, std::greater<Label>> q;
+
+	nearest.assign(n, std::vector<std::pair<int, int>>());
+	if (k <= 0)
+		return;
+
+	for (int f : facilities)
+		q.push(Label{ 0, f, f });
+
+	// k is small in practice so a linear scan of a node's labels is
+	// cheaper than any set.
+	auto has = [&](int u, int f)
+	{
+		for (auto & p : nearest[u])
+			if (p.second == f)
+				return true;
+		return false;
+	};
+
+	while (!q.empty())
+	{
+		Label l = q.top();
+		q.pop();
+		if ((int) nearest[l.node].size() >= k || has(l.node, l.facility))
+			continue;
+		nearest[l.node].push_back(std::make_pair(l.cost, l.facility));
+
+		for (auto e : g.OutEdges(l.node))
+		{
+			int v = e.to;
+			if ((int) nearest[v].size() < k && !has(v, l.facility))
+				q.push(Label{ l.cost + e.weight, v, l.facility });
+		}
+	}
+}
+
+// ReverseKNearest() - the nodes which count facility f among their k
+// nearest facilities. That is, the customers f would serve if every
+// customer were willing to use any of its k closest facilities.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::vector<int> & facilities	- the facility nodes (f among them).
+//	int k						- see above.
+//	int f						- the facility being asked about.
+// Returns:
+//	std::vector<int>			- the nodes, in increasing order.
+template <GraphView G>
+std::vector<int> ReverseKNearest(const G & g, const std::vector<int> & facilities, int k, int f)
+{
+	int n = g.NodeCount();
+	std::vector<std::vector<std::pair<int, int>>> nearest;
+	std::vector<int> result;
+
+	KNearestFacilities(g, facilities, k, nearest);
+	for (int v = 0; v < n; v++)
+	{
+		for (auto & p : nearest[v])
+		{
+			if (p.second == f)
+			{
+				result.push_back(v);
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+// GreedyPMedian() - choose p of the candidate nodes as facilities so as to
+// reduce the sum over all nodes of the cost to the nearest facility.
+// Nodes not yet served by any facility are charged a penalty larger than
+// any path could cost, so the first picks favor covering everything.
+//
+// Each round needs, for every remaining candidate, the total improvement
+// it would bring. Rather than a full dijkstra() per candidate per round,
+// PrunedDijkstra() is fenced by the current best costs so it only visits
+// the nodes that the candidate would take over.
+//
+// Improvements can only shrink as facilities are added (a node already
+// close to a facility has less to gain). So a candidate whose stale
+// improvement is still the best of the bunch after being brought up to
+// date must be the winner, without re-evaluating the others. This is the
+// "lazy greedy" trick and it skips most of the work after the first round.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::vector<int> & candidates	- where facilities may be placed.
+//	int p						- how many facilities to place.
+//	std::vector<int> & best		- receives the cost from each node to its
+//								  nearest chosen facility (INT_MAX if none).
+// Returns:
+//	std::vector<int>			- the chosen facilities in the order picked.
+template <GraphView G>
+std::vector<int> GreedyPMedian(const G & g, const std::vector<int> & candidates, int p, std::vector<int> & best)
+{
+	int n = g.NodeCount();
+	// The penalty for an unserved node must exceed the longest possible
+	// path, which cannot be more than the sum of all edge costs.
+	long long penalty = 1;
+	for (int u = 0; u < n; u++)
+		for (auto e : g.OutEdges(u))
+			penalty += e.weight;
+
+	std::vector<int> dist(n, INT_MAX);
+	std::vector<int> touched;
+	std::vector<int> chosen;
+	std::vector<bool> used(n, false);
+
+	best.assign(n, INT_MAX);
+
+	// The improvement candidate c brings. dist holds the costs from c
+	// for just the touched nodes which are reset before returning.
+	auto gain = [&](int c) -> long long
+	{
+		long long total = 0;
+		PrunedDijkstra(g, c, best, dist, touched);
+		for (int v : touched)
+		{
+			total += (best[v] == INT_MAX ? penalty : best[v]) - dist[v];
+			dist[v] = INT_MAX;
+		}
+		return total;
+	};
+
+	// (gain, round in which the gain was computed, candidate)
+	typedef std::pair<long long, std::pair<int, int>> Entry;
+	std::priority_queue<Entry> q;
+	for (int c : candidates)
+	{
+		if (!used[c])
+		{
+			used[c] = true;
+			q.push(Entry(gain(c), std::make_pair(0, c)));
+		}
+	}
+
+	for (int round = 0; round < p && !q.empty(); round++)
+	{
+		while (!q.empty())
+		{
+			Entry e = q.top();
+			q.pop();
+			int c = e.second.second;
+			if (e.second.first != round)
+			{
+				q.push(Entry(gain(c), std::make_pair(round, c)));
+				continue;
+			}
+			if (e.first <= 0)
+				break;
+
+			// c wins. Commit its improvements to best.
+			PrunedDijkstra(g, c, best, dist, touched);
+			for (int v : touched)
+			{
+				best[v] = dist[v];
+				dist[v] = INT_MAX;
+			}
+			chosen.push_back(c);
+			break;
+		}
+		if ((int) chosen.size() != round + 1)
+			break;
+	}
+	return chosen;
+}
@@ -0,0 +1,470 @@
+// Binary Graph Files
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// A binary graph file holds exactly the image SharedGraph.h places in
+// shared memory: a header, the CSR offsets and the edges. Loading one is
+// nothing more than getting its bytes into memory and checking them.
+// Three ways of doing that are offered:
+//
+//	load_mmap	map the file and let page faults bring it in. Simple, but
+//				each fault is taken one at a time by the loading thread
+//				so the drive sees one small request after another.
+//	load_read	read() the file in large pieces, still one at a time.
+//	load_uring	io_uring: many large reads are in flight at once, as an
+//				NVMe drive wants. The file is opened with O_DIRECT when
+//				the file system allows, so the data goes straight into
+//				the buffer without passing through the page cache.
+//
+// The buffer for load_read and load_uring is backed by huge pages when
+// the system has some reserved (MAP_HUGETLB), and otherwise asks for
+// transparent huge pages. Fewer, larger pages mean fewer TLB misses when
+// the graph is searched later.
+//
+// Checking the image (offsets never decrease, edges lead to real nodes,
+// weights are not negative) is overlapped with loading: as each prefix of
+// the file arrives it is checked while the rest is still being read.
+//
+// There is no dependency on liburing. The few io_uring system calls are
+// made directly. If the kernel refuses io_uring, load_uring quietly falls
+// back to load_read.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include <cerrno>
+#include <algorithm>
+#include <atomic>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "GraphView.h"
+#include "SharedGraph.h"
+
+enum GraphFileMethod { load_mmap, load_read, load_uring };
+
+const size_t graph_file_chunk = 4 << 20;
+
+// SaveGraphFile() - writes any view as a binary graph file.
+//
+// Parameters:
+//	const G & g					- the graph.
+//	const std::string & path	- the file to write.
+// Returns:
+//	bool						- false if the file could not be written.
+template <GraphView G>
+bool SaveGraphFile(const G & g, const std::string & path)
+{
+	std::vector<uint64_t> offsets(g.NodeCount() + 1, 0);
+	for (int u = 0; u < g.NodeCount(); u++)
+		offsets[u + 1] = offsets[u] + (uint64_t) std::ranges::distance(g.OutEdges(u));
+	GraphImageHeader h = GraphImageLayout(g.NodeCount(), offsets.back());
+	h.magic = graph_image_magic;
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write((const char *) &h, sizeof(h));
+	out.write((const char *) offsets.data(), offsets.size() * sizeof(uint64_t));
+	for (int u = 0; u < g.NodeCount(); u++)
+	{
+		for (auto e : g.OutEdges(u))
+		{
+			Edge edge{ e.to, e.weight };
+			out.write((const char *) &edge, sizeof(edge));
+		}
+	}
+	return out.good();
+}
+
+// IoRing - just enough of io_uring to keep many reads in flight.
+class IoRing
+{
+public:
+	IoRing(const IoRing &) = delete;
+	IoRing & operator=(const IoRing &) = delete;
+	IoRing() = default;
+
+	~IoRing()
+	{
+		if (sqes != nullptr)
+			munmap(sqes, sqes_size);
+		if (cq_ring != nullptr && cq_ring != sq_ring)
+			munmap(cq_ring, cq_size);
+		if (sq_ring != nullptr)
+			munmap(sq_ring, sq_size);
+		if (ring >= 0)
+			close(ring);
+	}
+
+	// Setup() - creates a ring with room for the given number of reads.
+	bool Setup(unsigned depth)
+	{
+		io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		ring = (int) syscall(__NR_io_uring_setup, depth, &p);
+		if (ring < 0)
+			return false;
+		entries = p.sq_entries;
+
+		sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP)
+			sq_size = cq_size = std::max(sq_size, cq_size);
+		sq_ring = Map(sq_size, IORING_OFF_SQ_RING);
+		if (sq_ring == nullptr)
+			return false;
+		cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP) ? sq_ring : Map(cq_size, IORING_OFF_CQ_RING);
+		sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+		void * s = cq_ring == nullptr ? nullptr : Map(sqes_size, IORING_OFF_SQES);
+		if (s == nullptr)
+			return false;
+		sqes = (io_uring_sqe *) s;
+
+		char * sq = (char *) sq_ring;
+		char * cq = (char *) cq_ring;
+		sq_tail = (unsigned *) (sq + p.sq_off.tail);
+		sq_mask = *(unsigned *) (sq + p.sq_off.ring_mask);
+		sq_array = (unsigned *) (sq + p.sq_off.array);
+		cq_head = (unsigned *) (cq + p.cq_off.head);
+		cq_tail = (unsigned *) (cq + p.cq_off.tail);
+		cq_mask = *(unsigned *) (cq + p.cq_off.ring_mask);
+		cqes = (io_uring_cqe *) (cq + p.cq_off.cqes);
+		return true;
+	}
+
+	unsigned Depth() const
+	{
+		return entries;
+	}
+
+	// QueueRead() - adds a read to the submission queue. The caller keeps
+	// no more than Depth() reads outstanding.
+	void QueueRead(int fd, char * buffer, unsigned size, uint64_t offset, uint64_t tag)
+	{
+		unsigned tail = *sq_tail;
+		unsigned i = tail & sq_mask;
+		io_uring_sqe & sqe = sqes[i];
+		memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_READ;
+		sqe.fd = fd;
+		sqe.addr = (uint64_t) (uintptr_t) buffer;
+		sqe.len = size;
+		sqe.off = offset;
+		sqe.user_data = tag;
+		sq_array[i] = i;
+		std::atomic_ref<unsigned>(*sq_tail).store(tail + 1, std::memory_order_release);
+		queued++;
+	}
+
+	// Submit() - hands the queued reads to the kernel and waits until at
+	// least one read has finished.
+	bool Submit()
+	{
+		int r;
+		do
+			r = (int) syscall(__NR_io_uring_enter, ring, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		while (r < 0 && errno == EINTR);
+		if (r < 0)
+			return false;
+		queued -= std::min(queued, (unsigned) r);
+		return true;
+	}
+
+	// Wait() - waits until at least one read has finished without handing
+	// the kernel any more.
+	bool Wait()
+	{
+		int r;
+		do
+			r = (int) syscall(__NR_io_uring_enter, ring, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		while (r < 0 && errno == EINTR);
+		return r >= 0;
+	}
+
+	// Queued() - reads queued but not yet handed to the kernel.
+	unsigned Queued() const
+	{
+		return queued;
+	}
+
+	// Reap() - calls f(tag, result) for every finished read.
+	template <typename F>
+	void Reap(F f)
+	{
+		unsigned head = *cq_head;
+		unsigned tail = std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire);
+		for (; head != tail; head++)
+		{
+			io_uring_cqe & cqe = cqes[head & cq_mask];
+			f(cqe.user_data, cqe.res);
+		}
+		std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+	}
+
+private:
+	void * Map(size_t size, off_t what)
+	{
+		void * p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, what);
+		return p == MAP_FAILED ? nullptr : p;
+	}
+
+	int ring = -1;
+	unsigned entries = 0;
+	unsigned queued = 0;
+	void * sq_ring = nullptr;
+	void * cq_ring = nullptr;
+	size_t sq_size = 0;
+	size_t cq_size = 0;
+	io_uring_sqe * sqes = nullptr;
+	size_t sqes_size = 0;
+	unsigned * sq_tail = nullptr;
+	unsigned sq_mask = 0;
+	unsigned * sq_array = nullptr;
+	unsigned * cq_head = nullptr;
+	unsigned * cq_tail = nullptr;
+	unsigned cq_mask = 0;
+	io_uring_cqe * cqes = nullptr;
+};
+
+// GraphFile - a binary graph file loaded into memory. It is a GraphView.
+class GraphFile : public GraphImage
+{
+public:
+	GraphFile() = default;
+	GraphFile(const GraphFile &) = delete;
+	GraphFile & operator=(const GraphFile &) = delete;
+
+	~GraphFile()
+	{
+		Release();
+	}
+
+	// Load() - loads and checks a binary graph file.
+	//
+	// Parameters:
+	//	const std::string & path	- the file.
+	//	GraphFileMethod method		- how to bring the file into memory.
+	// Returns:
+	//	bool						- false if the file could not be read
+	//								  or is not a well formed graph.
+	bool Load(const std::string & path, GraphFileMethod method = load_uring)
+	{
+		Release();
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+		size = ok ? (uint64_t) st.st_size : 0;
+		used = method;
+
+		if (ok && method == load_mmap)
+			ok = LoadMapped(fd);
+		else if (ok)
+		{
+			ok = Allocate();
+			if (ok && method == load_uring)
+			{
+				int direct = open(path.c_str(), O_RDONLY | O_DIRECT);
+				int status = LoadUring(direct >= 0 ? direct : fd);
+				if (direct >= 0)
+					close(direct);
+				if (status < 0)
+					used = load_read;
+				ok = status > 0;
+			}
+			if (ok && used == load_read)
+				ok = LoadRead(fd);
+		}
+		close(fd);
+		if (ok)
+			ok = Bind(memory, size);
+		if (!ok)
+			Release();
+		return ok;
+	}
+
+	// Method() - how the file was actually loaded.
+	GraphFileMethod Method() const
+	{
+		return used;
+	}
+
+	// HugePages() - true if the buffer is backed by reserved huge pages.
+	bool HugePages() const
+	{
+		return huge;
+	}
+
+private:
+	// Allocate() - a buffer rounded up to whole chunks (O_DIRECT may read
+	// a little past the end of the file) and backed by huge pages if
+	// possible.
+	bool Allocate()
+	{
+		mapped = (size + graph_file_chunk - 1) / graph_file_chunk * graph_file_chunk;
+		void * p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		huge = p != MAP_FAILED;
+		if (!huge)
+		{
+			p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				return false;
+			madvise(p, mapped, MADV_HUGEPAGE);
+		}
+		memory = (char *) p;
+		return true;
+	}
+
+	bool LoadMapped(int fd)
+	{
+		void * p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+			return false;
+		memory = (char *) p;
+		mapped = size;
+		madvise(p, size, MADV_SEQUENTIAL);
+		GraphImageChecker checker(size);
+		return checker.Check(memory, size) && checker.Complete();
+	}
+
+	bool LoadRead(int fd)
+	{
+		GraphImageChecker checker(size);
+		uint64_t ready = 0;
+		while (ready < size)
+		{
+			ssize_t n = pread(fd, memory + ready, std::min<uint64_t>(graph_file_chunk, size - ready), ready);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return false;
+			ready += n;
+			if (!checker.Check(memory, ready))
+				return false;
+		}
+		return checker.Complete();
+	}
+
+	// LoadUring() - keeps the ring full of chunk sized reads. Chunks can
+	// finish in any order. The checker is given the longest run of
+	// finished chunks from the start of the file.
+	//
+	// Returns:
+	//	int		- 1 on success, 0 if the file is bad or the buffer had to
+	//			  be abandoned, -1 if io_uring could not be used (so the
+	//			  caller falls back to pread()).
+	int LoadUring(int fd)
+	{
+		IoRing ring;
+		if (!ring.Setup(32))
+			return -1;
+
+		size_t chunks = mapped / graph_file_chunk;
+		std::vector<uint64_t> filled(chunks, 0);
+		GraphImageChecker checker(size);
+		size_t next = 0;
+		size_t prefix = 0;
+		unsigned in_flight = 0;
+		bool failed = false;
+		bool good = true;
+
+		auto chunk_end = [&](size_t c)
+		{
+			return std::min<uint64_t>(graph_file_chunk, size - c * graph_file_chunk);
+		};
+
+		// drain() - waits for every read the kernel holds, since they may
+		// land in the buffer at any time until they finish. Reads still in
+		// the queue were never handed over and never will be. If the wait
+		// itself fails the buffer is abandoned rather than unmapped, so it
+		// can never be reused while a read is writing into it.
+		auto drain = [&]()
+		{
+			in_flight -= ring.Queued();
+			while (in_flight > 0 && ring.Wait())
+				ring.Reap([&](uint64_t, int) { in_flight--; });
+			if (in_flight == 0)
+				return true;
+			memory = nullptr;
+			mapped = 0;
+			return false;
+		};
+
+		while (prefix < chunks && good)
+		{
+			while (in_flight < ring.Depth() && next < chunks)
+			{
+				ring.QueueRead(fd, memory + next * graph_file_chunk, graph_file_chunk, next * graph_file_chunk, next);
+				next++;
+				in_flight++;
+			}
+			if (!ring.Submit())
+				return drain() ? -1 : 0;
+			ring.Reap([&](uint64_t c, int result)
+			{
+				in_flight--;
+				if (result <= 0)
+				{
+					failed = true;
+					return;
+				}
+				filled[c] += result;
+				if (filled[c] < chunk_end(c))
+				{
+					ring.QueueRead(fd, memory + c * graph_file_chunk + filled[c], (unsigned) (graph_file_chunk - filled[c]),
+						c * graph_file_chunk + filled[c], c);
+					in_flight++;
+				}
+			});
+			if (failed)
+				return drain() ? -1 : 0;
+			while (prefix < chunks && filled[prefix] >= chunk_end(prefix))
+				prefix++;
+			good = checker.Check(memory, std::min<uint64_t>(size, prefix * graph_file_chunk));
+		}
+		if (!drain())
+			return 0;
+		return good && checker.Complete() ? 1 : 0;
+	}
+
+	void Release()
+	{
+		if (memory != nullptr)
+			munmap(memory, mapped);
+		memory = nullptr;
+		mapped = 0;
+		n = 0;
+		huge = false;
+	}
+
+	char * memory = nullptr;
+	uint64_t size = 0;
+	size_t mapped = 0;
+	bool huge = false;
+	GraphFileMethod used = load_uring;
+};
+
+// DropFromPageCache() - asks the kernel to forget its cached copy of a
+// file so the next load comes from the drive, as it would at a cold start.
+inline void DropFromPageCache(const std::string & path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
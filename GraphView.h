@@ -0,0 +1,452 @@
+// Graph Views
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// The demo keeps its graph in one dense vector. Other programs keep their
+// graphs in other ways and should not have to copy them into that vector
+// to use these algorithms. A "graph view" is anything that can answer two
+// questions:
+//
+//	NodeCount()		how many nodes are there (numbered 0 to NodeCount() - 1)?
+//	OutEdges(u)		what edges leave node u? Each edge has a to and a weight.
+//
+// The algorithms are templates written against the GraphView concept
+// below. The compiler builds a separate copy for each kind of view so
+// there is no virtual call or other indirection. Iterating the edges of
+// a CSR view compiles to the same loop one would write by hand.
+//
+// Three views are provided:
+//
+//	DenseView	wraps the demo's dense matrix without copying it.
+//	CsrGraph	compressed sparse row: every node's edges stored together.
+//	GridView	a 2D or 3D grid of cell costs whose edges are never stored.
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <concepts>
+#include <iterator>
+#include <ranges>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <thread>
+
+#include "Partition.h"
+
+struct Edge
+{
+	int to;
+	int weight;
+};
+
+template <typename E>
+concept WeightedEdge = requires(const E & e)
+{
+	{ e.to } -> std::convertible_to<int>;
+	{ e.weight } -> std::convertible_to<int>;
+};
+
+template <typename G>
+concept GraphView = requires(const G & g, int u)
+{
+	{ g.NodeCount() } -> std::convertible_to<int>;
+	{ g.OutEdges(u) } -> std::ranges::forward_range;
+} && WeightedEdge<std::ranges::range_value_t<decltype(std::declval<const G &>().OutEdges(0))>>;
+
+// DenseView - the demo's vector<int> graph seen as a GraphView. OutEdges()
+// walks the node's row skipping the -1 entries, just as dijkstra() does.
+class DenseView
+{
+public:
+	class Iterator
+	{
+	public:
+		typedef Edge value_type;
+		typedef std::ptrdiff_t difference_type;
+
+		Iterator() : row(nullptr), v(0), n(0)
+		{
+		}
+		Iterator(const int * row, int v, int n) : row(row), v(v), n(n)
+		{
+			Skip();
+		}
+		Edge operator*() const
+		{
+			return Edge{ v, row[v] };
+		}
+		Iterator & operator++()
+		{
+			v++;
+			Skip();
+			return *this;
+		}
+		Iterator operator++(int)
+		{
+			Iterator t = *this;
+			++*this;
+			return t;
+		}
+		bool operator==(const Iterator & o) const
+		{
+			return v == o.v;
+		}
+
+	private:
+		void Skip()
+		{
+			while (v < n && row[v] == -1)
+				v++;
+		}
+
+		const int * row;
+		int v;
+		int n;
+	};
+
+	DenseView(const std::vector<int> & g, int n) : g(g.data()), n(n)
+	{
+	}
+
+	int NodeCount() const
+	{
+		return n;
+	}
+
+	std::ranges::subrange<Iterator> OutEdges(int u) const
+	{
+		const int * row = g + (size_t) n * u;
+		return std::ranges::subrange<Iterator>(Iterator(row, 0, n), Iterator(row, n, n));
+	}
+
+	// Weight() - direct access to one entry for algorithms that need it.
+	int Weight(int u, int v) const
+	{
+		return g[(size_t) n * u + v];
+	}
+
+private:
+	const int * g;
+	int n;
+};
+
+// CsrGraph - compressed sparse row storage. The edges leaving node u are
+// edges[offsets[u]] up to (not including) edges[offsets[u + 1]]. This is
+// the sparse data structure the comments in Source.cpp allude to.
+class CsrGraph
+{
+public:
+	CsrGraph() = default;
+
+	// CsrGraph() - builds the CSR form of any other view.
+	template <GraphView G>
+	explicit CsrGraph(const G & g)
+	{
+		int n = g.NodeCount();
+		offsets.assign(n + 1, 0);
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+				edges.push_back(Edge{ e.to, e.weight });
+			offsets[u + 1] = edges.size();
+		}
+	}
+
+	// CsrGraph() - builds the CSR form of any other view using several
+	// threads. Degrees are counted by equal node ranges (nothing is known
+	// about where the edges are yet). The edges are then copied by equal
+	// edge ranges, so a hub's edges may be copied by several threads.
+	template <GraphView G>
+	CsrGraph(const G & g, int threads)
+	{
+		int n = g.NodeCount();
+		std::vector<std::thread> workers;
+
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		offsets.assign(n + 1, 0);
+
+		auto run = [&](auto work)
+		{
+			workers.clear();
+			for (int t = 1; t < threads; t++)
+				workers.push_back(std::thread(work, t));
+			work(0);
+			for (auto & w : workers)
+				w.join();
+		};
+
+		run([&](int t)
+		{
+			int last = (int) ((long long) n * (t + 1) / threads);
+			for (int u = (int) ((long long) n * t / threads); u < last; u++)
+				offsets[u + 1] = (size_t) std::ranges::distance(g.OutEdges(u));
+		});
+		for (int u = 0; u < n; u++)
+			offsets[u + 1] += offsets[u];
+
+		edges.resize(offsets[n]);
+		std::vector<EdgePosition> splits = SplitByEdges(offsets, threads);
+		run([&](int t)
+		{
+			ForEachInPart(offsets, splits, t, [&](size_t u, size_t first, size_t last)
+			{
+				auto out = g.OutEdges((int) u);
+				Edge * to = edges.data() + offsets[u] + first;
+				for (auto e : EdgeSlice(out, first, last))
+					*to++ = Edge{ e.to, e.weight };
+			});
+		});
+	}
+
+	// CsrGraph() - adopts arrays that are already in CSR form.
+	CsrGraph(std::vector<size_t> && offsets, std::vector<Edge> && edges) :
+		offsets(std::move(offsets)), edges(std::move(edges))
+	{
+	}
+
+	int NodeCount() const
+	{
+		return offsets.empty() ? 0 : (int) offsets.size() - 1;
+	}
+
+	size_t EdgeCount() const
+	{
+		return edges.size();
+	}
+
+	std::span<const Edge> OutEdges(int u) const
+	{
+		return std::span<const Edge>(edges.data() + offsets[u], edges.data() + offsets[u + 1]);
+	}
+
+	const std::vector<size_t> & Offsets() const
+	{
+		return offsets;
+	}
+
+	const std::vector<Edge> & Edges() const
+	{
+		return edges;
+	}
+
+private:
+	std::vector<size_t> offsets;
+	std::vector<Edge> edges;
+};
+
+// GridView - a 2D or 3D grid of cells, one cost per cell, stored layer
+// by layer and row by row. A cost of -1 marks a blocked cell. Each cell
+// is a node. The edges are computed when asked for and never stored, so
+// a 10,000 x 10,000 grid needs nothing beyond its array of costs.
+//
+// Which neighbors a cell has depends on the connectivity:
+//
+//	4	2D, up, down, left and right.
+//	8	2D, the above plus the four diagonals.
+//	6	3D, the six faces of a cube.
+//	26	3D, faces, edges and corners of a cube.
+//
+// Moving into a cell costs that cell's cost times the length of the
+// step. With 4 or 6 connectivity every step has length 1. With 8 or 26
+// connectivity steps are measured in tenths so that they stay integers:
+// 10 for a straight step, 14 for a diagonal across a square and 17 for a
+// diagonal across a cube (about 10 times 1, the square root of 2 and the
+// square root of 3).
+//
+// A diagonal step may not cut a corner: every cell it passes beside
+// (those reached by taking only some of its component steps) must be
+// unblocked too.
+class GridView
+{
+public:
+	// The out edges of one cell. Small enough to return by value.
+	struct Edges
+	{
+		Edge edge[26];
+		int count = 0;
+
+		const Edge * begin() const
+		{
+			return edge;
+		}
+		const Edge * end() const
+		{
+			return edge + count;
+		}
+	};
+
+	// GridView() - a 2D grid.
+	GridView(const std::vector<int> & cost, int rows, int cols, int connectivity = 4) :
+		GridView(cost, 1, rows, cols, connectivity)
+	{
+	}
+
+	// GridView() - a 3D grid. A layers value of 1 makes a 2D grid.
+	GridView(const std::vector<int> & cost, int layers, int rows, int cols, int connectivity) :
+		cost(cost.data()), layers(layers), rows(rows), cols(cols), connectivity(connectivity)
+	{
+		bool diagonals = connectivity == 8 || connectivity == 26;
+		int dz_max = layers > 1 ? 1 : 0;
+		const int step_length[] = { 0, 10, 14, 17 };
+
+		for (int dz = -dz_max; dz <= dz_max; dz++)
+		{
+			for (int dr = -1; dr <= 1; dr++)
+			{
+				for (int dc = -1; dc <= 1; dc++)
+				{
+					int axes = (dz != 0) + (dr != 0) + (dc != 0);
+					if (axes == 0 || (!diagonals && axes > 1))
+						continue;
+					Move m;
+					m.dz = dz;
+					m.dr = dr;
+					m.dc = dc;
+					m.length = diagonals ? step_length[axes] : 1;
+					m.offset = ((long long) dz * rows + dr) * cols + dc;
+					// The cells beside a diagonal step: every way of
+					// leaving out at least one of its component steps.
+					m.beside_count = 0;
+					for (int keep = 1; keep < 7; keep++)
+					{
+						if (((keep & 4) && !dz) || ((keep & 2) && !dr) || ((keep & 1) && !dc))
+							continue;
+						int bz = (keep & 4) ? dz : 0;
+						int br = (keep & 2) ? dr : 0;
+						int bc = (keep & 1) ? dc : 0;
+						if ((bz != 0) + (br != 0) + (bc != 0) == axes)
+							continue;
+						m.beside[m.beside_count++] = ((long long) bz * rows + br) * cols + bc;
+					}
+					moves.push_back(m);
+				}
+			}
+		}
+
+		min_cost = INT_MAX;
+		for (size_t i = 0; i < (size_t) NodeCount(); i++)
+			if (cost[i] != -1)
+				min_cost = std::min(min_cost, cost[i]);
+		if (min_cost == INT_MAX)
+			min_cost = 0;
+	}
+
+	int NodeCount() const
+	{
+		return layers * rows * cols;
+	}
+
+	int Layers() const
+	{
+		return layers;
+	}
+
+	int Rows() const
+	{
+		return rows;
+	}
+
+	int Cols() const
+	{
+		return cols;
+	}
+
+	int Connectivity() const
+	{
+		return connectivity;
+	}
+
+	int Cell(int z, int r, int c) const
+	{
+		return (z * rows + r) * cols + c;
+	}
+
+	bool Blocked(int u) const
+	{
+		return cost[u] == -1;
+	}
+
+	int CellCost(int u) const
+	{
+		return cost[u];
+	}
+
+	Edges OutEdges(int u) const
+	{
+		Edges e;
+		int c = u % cols;
+		int r = u / cols % rows;
+		int z = u / cols / rows;
+
+		for (const Move & m : moves)
+		{
+			if ((unsigned) (z + m.dz) >= (unsigned) layers ||
+				(unsigned) (r + m.dr) >= (unsigned) rows ||
+				(unsigned) (c + m.dc) >= (unsigned) cols)
+				continue;
+			int v = (int) (u + m.offset);
+			if (cost[v] == -1)
+				continue;
+			bool clear = true;
+			for (int i = 0; i < m.beside_count && clear; i++)
+				clear = cost[u + m.beside[i]] != -1;
+			if (clear)
+				e.edge[e.count++] = Edge{ v, cost[v] * m.length };
+		}
+		return e;
+	}
+
+	// Heuristic() - a lower bound on the cost from u to t: the cheapest
+	// cell cost times the length of the shortest obstacle free route.
+	// Never overestimates, as A* requires.
+	int Heuristic(int u, int t) const
+	{
+		int a = std::abs(u % cols - t % cols);
+		int b = std::abs(u / cols % rows - t / cols % rows);
+		int c = std::abs(u / cols / rows - t / cols / rows);
+
+		// Sort so that a >= b >= c.
+		if (a < b)
+			std::swap(a, b);
+		if (b < c)
+			std::swap(b, c);
+		if (a < b)
+			std::swap(a, b);
+
+		long long length;
+		if (connectivity == 8 || connectivity == 26)
+			length = 17LL * c + 14LL * (b - c) + 10LL * (a - b);
+		else
+			length = (long long) a + b + c;
+		return (int) std::min<long long>(length * min_cost, INT_MAX - 1);
+	}
+
+private:
+	struct Move
+	{
+		int dz, dr, dc;
+		int length;
+		long long offset;
+		long long beside[6];
+		int beside_count;
+	};
+
+	const int * cost;
+	int layers;
+	int rows;
+	int cols;
+	int connectivity;
+	int min_cost;
+	std::vector<Move> moves;
+};
+
+static_assert(GraphView<DenseView>);
+static_assert(GraphView<CsrGraph>);
+static_assert(GraphView<GridView>);
@@ -0,0 +1,589 @@
+// Jump Point Search
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// On a grid where every open cell costs the same there are a great many
+// least cost routes between two cells, all the same cost, differing only
+// in the order of their steps. dijkstra() and A* dutifully explore all of
+// them. Jump point search (Harabor and Grastien) avoids this by only ever
+// stopping at "jump points": cells where a route might need to turn
+// because an obstacle beside it opens up a new direction ("forced
+// neighbors"). From any other cell the search simply keeps going in the
+// same direction without putting anything on the heap.
+//
+// This version works on a 2D GridView with 8 connectivity. It follows the
+// same no corner cutting rule as GridView so its costs match A* and
+// dijkstra() on the same view exactly.
+//
+// Three variants of the straight line jump are offered:
+//
+//	jps_scan	steps one cell at a time, as described above.
+//	jps_bits	keeps the open cells as bits, 64 to a word, and finds the
+//				next blocked cell or forced neighbor along a row with a
+//				handful of word operations and a count of trailing zeros.
+//				Columns are scanned the same way in a transposed copy.
+//	jps_plus	"JPS+" (Rabin). Before any search, records for every cell
+//				and each of the 8 directions how far away the next jump
+//				point (or wall) is. A jump is then a single table lookup.
+//				The table costs 16 bytes per cell.
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <climits>
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "GraphView.h"
+
+// BitGrid - one bit per cell, set if the cell is open. Each row is padded
+// with at least one zero bit on the right and the grid with an all zero
+// row above and below, so cells off the grid read as blocked without any
+// bounds checks in the scanning loops.
+class BitGrid
+{
+public:
+	// Build() - copies the open cells of a 2D grid, optionally transposed
+	// so that columns of the grid become rows of bits.
+	void Build(const GridView & g, bool transpose)
+	{
+		rows = transpose ? g.Cols() : g.Rows();
+		cols = transpose ? g.Rows() : g.Cols();
+		words = cols / 64 + 1;
+		bits.assign((size_t) (rows + 2) * words, 0);
+		for (int r = 0; r < rows; r++)
+			for (int c = 0; c < cols; c++)
+				if (!g.Blocked(transpose ? c * g.Cols() + r : r * g.Cols() + c))
+					Row(r)[c / 64] |= 1ull << (c % 64);
+	}
+
+	bool Get(int r, int c) const
+	{
+		if ((unsigned) c >= (unsigned) cols)
+			return false;
+		return (Row(r)[c / 64] >> (c % 64)) & 1;
+	}
+
+	// Forward() - moving right along row r starting at column c, the first
+	// column that is blocked or has a forced neighbor (open above or below
+	// where the cell behind it above or below is blocked).
+	//
+	// Parameters:
+	//	int r			- the row.
+	//	int c			- the first column to look at.
+	//	bool & blocked	- set to true if the column found is blocked.
+	// Returns:
+	//	int				- the column.
+	int Forward(int r, int c, bool & blocked) const
+	{
+		const uint64_t * row = Row(r);
+		const uint64_t * up = Row(r - 1);
+		const uint64_t * down = Row(r + 1);
+
+		for (int w = c / 64; w < words; w++)
+		{
+			// The bit from the word before stands in for column -1 of this word.
+			uint64_t up_behind = (up[w] << 1) | (w > 0 ? up[w - 1] >> 63 : 0);
+			uint64_t down_behind = (down[w] << 1) | (w > 0 ? down[w - 1] >> 63 : 0);
+			uint64_t closed = ~row[w];
+			uint64_t stop = closed | (up[w] & ~up_behind) | (down[w] & ~down_behind);
+			if (w == c / 64)
+				stop &= ~0ull << (c % 64);
+			if (stop)
+			{
+				int bit = std::countr_zero(stop);
+				blocked = (closed >> bit) & 1;
+				return w * 64 + bit;
+			}
+		}
+		// Not reached: the padding bits are always closed.
+		blocked = true;
+		return cols;
+	}
+
+	// Backward() - as Forward() but moving left. Returns -1 (blocked) on
+	// running off the left edge.
+	int Backward(int r, int c, bool & blocked) const
+	{
+		const uint64_t * row = Row(r);
+		const uint64_t * up = Row(r - 1);
+		const uint64_t * down = Row(r + 1);
+
+		for (int w = c / 64; w >= 0; w--)
+		{
+			uint64_t up_behind = (up[w] >> 1) | (w + 1 < words ? up[w + 1] << 63 : 0);
+			uint64_t down_behind = (down[w] >> 1) | (w + 1 < words ? down[w + 1] << 63 : 0);
+			uint64_t closed = ~row[w];
+			uint64_t stop = closed | (up[w] & ~up_behind) | (down[w] & ~down_behind);
+			if (w == c / 64 && c % 64 != 63)
+				stop &= (1ull << (c % 64 + 1)) - 1;
+			if (stop)
+			{
+				int bit = 63 - std::countl_zero(stop);
+				blocked = (closed >> bit) & 1;
+				return w * 64 + bit;
+			}
+		}
+		blocked = true;
+		return -1;
+	}
+
+private:
+	uint64_t * Row(int r)
+	{
+		return bits.data() + (size_t) (r + 1) * words;
+	}
+
+	const uint64_t * Row(int r) const
+	{
+		return bits.data() + (size_t) (r + 1) * words;
+	}
+
+	int rows = 0;
+	int cols = 0;
+	int words = 0;
+	std::vector<uint64_t> bits;
+};
+
+enum JpsVariant
+{
+	jps_scan,
+	jps_bits,
+	jps_plus
+};
+
+class JumpPointSearch
+{
+public:
+	// JumpPointSearch() - checks that the grid is one jump point search
+	// applies to (if not, Usable() returns false) and builds whatever the
+	// chosen variant needs ahead of time.
+	explicit JumpPointSearch(const GridView & grid, JpsVariant variant = jps_bits) :
+		grid(grid), rows(grid.Rows()), cols(grid.Cols()), variant(variant)
+	{
+		usable = grid.Layers() == 1 && grid.Connectivity() == 8;
+		cell_cost = -1;
+		for (int u = 0; u < grid.NodeCount() && usable; u++)
+		{
+			int c = grid.CellCost(u);
+			if (c == -1)
+				continue;
+			if (cell_cost == -1)
+				cell_cost = c;
+			usable = c == cell_cost;
+		}
+		dist.assign(grid.NodeCount(), INT_MAX);
+		prev.assign(grid.NodeCount(), -1);
+
+		if (!usable)
+			return;
+		if (variant == jps_bits)
+		{
+			by_rows.Build(grid, false);
+			by_cols.Build(grid, true);
+		}
+		else if (variant == jps_plus)
+		{
+			// Jump distances are stored as 16 bit values.
+			usable = rows < 32768 && cols < 32768;
+			if (usable)
+				BuildJumpTable();
+		}
+	}
+
+	// Usable() - true if the grid is 2D, 8 connected and uniform cost.
+	bool Usable() const
+	{
+		return usable;
+	}
+
+	// Search() - a least cost route from s to t.
+	//
+	// Parameters:
+	//	int s					- the source cell.
+	//	int t					- the target cell.
+	//	std::vector<int> & path	- receives every cell of the route from s
+	//							  to t (empty if there is none).
+	//	size_t * expanded		- if not null, receives the number of jump
+	//							  points taken off the heap.
+	// Returns:
+	//	int						- the cost of the route or INT_MAX.
+	int Search(int s, int t, std::vector<int> & path, size_t * expanded = nullptr)
+	{
+		struct Entry
+		{
+			int f;
+			int cost;
+			int node;
+			bool operator>(const Entry & o) const
+			{
+				return f != o.f ? f > o.f : cost < o.cost;
+			}
+		};
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> q;
+		size_t settled = 0;
+		int tr = t / cols;
+		int tc = t % cols;
+		int result = INT_MAX;
+
+		// dist and prev are kept between searches. Only the cells this
+		// search touched are reset, so a query that stays local does not
+		// pay for the whole grid.
+		for (int u : touched)
+		{
+			dist[u] = INT_MAX;
+			prev[u] = -1;
+		}
+		touched.clear();
+		path.clear();
+		if (!usable || grid.Blocked(s) || grid.Blocked(t))
+			return INT_MAX;
+
+		dist[s] = 0;
+		touched.push_back(s);
+		q.push(Entry{ Octile(s, t), 0, s });
+
+		int successors[8][2];
+		while (!q.empty())
+		{
+			Entry e = q.top();
+			q.pop();
+			int u = e.node;
+			if (e.cost != dist[u])
+				continue;
+			settled++;
+			if (u == t)
+			{
+				result = dist[t];
+				break;
+			}
+
+			int r = u / cols;
+			int c = u % cols;
+			int count = Directions(u, successors);
+			for (int i = 0; i < count; i++)
+			{
+				int dr = successors[i][0];
+				int dc = successors[i][1];
+				int v;
+				if (variant == jps_plus)
+					v = TableJump(u, dr, dc, tr, tc);
+				else
+					v = Jump(r + dr, c + dc, dr, dc, tr, tc);
+				if (v == -1)
+					continue;
+				int newDist = dist[u] + Octile(u, v);
+				if (newDist < dist[v])
+				{
+					if (dist[v] == INT_MAX)
+						touched.push_back(v);
+					dist[v] = newDist;
+					prev[v] = u;
+					q.push(Entry{ newDist + Octile(v, t), newDist, v });
+				}
+			}
+		}
+
+		if (expanded)
+			*expanded = settled;
+		if (result != INT_MAX)
+			FillPath(s, t, path);
+		return result;
+	}
+
+private:
+	bool Walkable(int r, int c) const
+	{
+		return (unsigned) r < (unsigned) rows && (unsigned) c < (unsigned) cols && !grid.Blocked(r * cols + c);
+	}
+
+	// Octile() - the cost of the straight or diagonal line from u to v.
+	int Octile(int u, int v) const
+	{
+		int a = std::abs(u / cols - v / cols);
+		int b = std::abs(u % cols - v % cols);
+		if (a < b)
+			std::swap(a, b);
+		return (14 * b + 10 * (a - b)) * cell_cost;
+	}
+
+	// Directions() - the directions worth searching from u. At the source
+	// that is every open direction. Elsewhere it is the direction of travel
+	// plus any directions opened up by obstacles (the pruning rules).
+	int Directions(int u, int out[8][2]) const
+	{
+		int r = u / cols;
+		int c = u % cols;
+		int count = 0;
+		auto add = [&](int dr, int dc)
+		{
+			out[count][0] = dr;
+			out[count][1] = dc;
+			count++;
+		};
+
+		if (prev[u] == -1)
+		{
+			for (int dr = -1; dr <= 1; dr++)
+				for (int dc = -1; dc <= 1; dc++)
+					if ((dr || dc) && Walkable(r + dr, c + dc) && Walkable(r + dr, c) && Walkable(r, c + dc))
+						add(dr, dc);
+			return count;
+		}
+
+		int pr = prev[u] / cols;
+		int pc = prev[u] % cols;
+		int dr = (r > pr) - (r < pr);
+		int dc = (c > pc) - (c < pc);
+
+		if (dr && dc)
+		{
+			bool vertical = Walkable(r + dr, c);
+			bool horizontal = Walkable(r, c + dc);
+			if (vertical)
+				add(dr, 0);
+			if (horizontal)
+				add(0, dc);
+			if (vertical && horizontal)
+				add(dr, dc);
+		}
+		else if (dc)
+		{
+			bool ahead = Walkable(r, c + dc);
+			bool up = Walkable(r - 1, c);
+			bool down = Walkable(r + 1, c);
+			if (ahead)
+			{
+				add(0, dc);
+				if (up)
+					add(-1, dc);
+				if (down)
+					add(1, dc);
+			}
+			if (up)
+				add(-1, 0);
+			if (down)
+				add(1, 0);
+		}
+		else
+		{
+			bool ahead = Walkable(r + dr, c);
+			bool left = Walkable(r, c - 1);
+			bool right = Walkable(r, c + 1);
+			if (ahead)
+			{
+				add(dr, 0);
+				if (left)
+					add(dr, -1);
+				if (right)
+					add(dr, 1);
+			}
+			if (left)
+				add(0, -1);
+			if (right)
+				add(0, 1);
+		}
+		return count;
+	}
+
+	// Jump() - steps from cell (r, c) in direction (dr, dc) until reaching
+	// the target, a jump point, or a dead end (returns -1). A cell on a
+	// straight line is a jump point when an obstacle just behind it to one
+	// side ends right there. A cell on a diagonal is a jump point when a
+	// straight line from it leads to one.
+	int Jump(int r, int c, int dr, int dc, int tr, int tc) const
+	{
+		if (variant == jps_bits && !(dr && dc))
+			return BitJump(r, c, dr, dc, tr, tc);
+
+		while (true)
+		{
+			if (!Walkable(r, c))
+				return -1;
+			if (r == tr && c == tc)
+				return r * cols + c;
+
+			if (dr && dc)
+			{
+				if (Jump(r, c + dc, 0, dc, tr, tc) != -1 || Jump(r + dr, c, dr, 0, tr, tc) != -1)
+					return r * cols + c;
+				if (!Walkable(r, c + dc) || !Walkable(r + dr, c))
+					return -1;
+			}
+			else if (dc)
+			{
+				if ((Walkable(r - 1, c) && !Walkable(r - 1, c - dc)) ||
+					(Walkable(r + 1, c) && !Walkable(r + 1, c - dc)))
+					return r * cols + c;
+			}
+			else
+			{
+				if ((Walkable(r, c - 1) && !Walkable(r - dr, c - 1)) ||
+					(Walkable(r, c + 1) && !Walkable(r - dr, c + 1)))
+					return r * cols + c;
+			}
+			r += dr;
+			c += dc;
+		}
+	}
+
+	// BitJump() - Jump() for straight lines using BitGrid scanning.
+	int BitJump(int r, int c, int dr, int dc, int tr, int tc) const
+	{
+		bool blocked;
+		int x;
+
+		if (!Walkable(r, c))
+			return -1;
+		if (dc)
+		{
+			x = dc > 0 ? by_rows.Forward(r, c, blocked) : by_rows.Backward(r, c, blocked);
+			if (tr == r && (dc > 0 ? tc >= c && tc <= x : tc <= c && tc >= x))
+				return tr * cols + tc;
+			return blocked ? -1 : r * cols + x;
+		}
+		x = dr > 0 ? by_cols.Forward(c, r, blocked) : by_cols.Backward(c, r, blocked);
+		if (tc == c && (dr > 0 ? tr >= r && tr <= x : tr <= r && tr >= x))
+			return tr * cols + tc;
+		return blocked ? -1 : x * cols + c;
+	}
+
+	// Direction() - numbers the 8 directions clockwise from north.
+	static int Direction(int dr, int dc)
+	{
+		static const int table[3][3] = { { 7, 0, 1 }, { 6, -1, 2 }, { 5, 4, 3 } };
+		return table[dr + 1][dc + 1];
+	}
+
+	// Forced() - true if cell (r, c), entered moving straight in direction
+	// (dr, dc), is a jump point. The same test Jump() makes.
+	bool Forced(int r, int c, int dr, int dc) const
+	{
+		if (dc)
+			return (Walkable(r - 1, c) && !Walkable(r - 1, c - dc)) ||
+				(Walkable(r + 1, c) && !Walkable(r + 1, c - dc));
+		return (Walkable(r, c - 1) && !Walkable(r - dr, c - 1)) ||
+			(Walkable(r, c + 1) && !Walkable(r - dr, c + 1));
+	}
+
+	// BuildJumpTable() - for every open cell and direction, the number of
+	// steps to the next jump point (positive) or the number of steps that
+	// can be taken before hitting a wall (zero or negative). The entry for
+	// a cell is worked out from the entry of the next cell in the same
+	// direction, so each direction is filled in starting from the far side.
+	// Straight directions go first as the diagonals depend on them.
+	void BuildJumpTable()
+	{
+		static const int order[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+		static const int step[8][2] = {
+			{ -1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, -1 }
+		};
+		size_t cells = (size_t) rows * cols;
+
+		jump_table.assign(8 * cells, 0);
+		for (int d : order)
+		{
+			int dr = step[d][0];
+			int dc = step[d][1];
+			int16_t * table = jump_table.data() + d * cells;
+			for (int i = 0; i < rows; i++)
+			{
+				int r = dr > 0 ? rows - 1 - i : i;
+				for (int j = 0; j < cols; j++)
+				{
+					int c = dc > 0 ? cols - 1 - j : j;
+					int nr = r + dr;
+					int nc = c + dc;
+					if (!Walkable(r, c) || !Walkable(nr, nc))
+						continue;
+					int next = nr * cols + nc;
+					bool jump_point;
+					if (dr && dc)
+					{
+						if (!Walkable(nr, c) || !Walkable(r, nc))
+							continue;
+						jump_point = jump_table[Direction(dr, 0) * cells + next] > 0 ||
+							jump_table[Direction(0, dc) * cells + next] > 0;
+					}
+					else
+						jump_point = Forced(nr, nc, dr, dc);
+					int after = table[next];
+					table[r * cols + c] = (int16_t) (jump_point ? 1 : after > 0 ? after + 1 : after - 1);
+				}
+			}
+		}
+	}
+
+	// TableJump() - Jump() for JPS+. The table gives the next jump point
+	// or wall in direction (dr, dc) from u. All that is left to do is to
+	// notice when the target lies on the way.
+	int TableJump(int u, int dr, int dc, int tr, int tc) const
+	{
+		int distance = jump_table[(size_t) Direction(dr, dc) * rows * cols + u];
+		int reach = std::abs(distance);
+		int r = u / cols;
+		int c = u % cols;
+		int toward_r = (tr > r) - (tr < r);
+		int toward_c = (tc > c) - (tc < c);
+
+		if (dr && dc)
+		{
+			// Stop level with the target, from there a straight line may reach it.
+			if (toward_r == dr && toward_c == dc)
+			{
+				int m = std::min(std::abs(tr - r), std::abs(tc - c));
+				if (m <= reach)
+					return u + m * (dr * cols + dc);
+			}
+		}
+		else if (dc ? tr == r && toward_c == dc && std::abs(tc - c) <= reach
+			: tc == c && toward_r == dr && std::abs(tr - r) <= reach)
+			return tr * cols + tc;
+
+		return distance > 0 ? u + distance * (dr * cols + dc) : -1;
+	}
+
+	// FillPath() - the jump points joined by straight and diagonal lines.
+	void FillPath(int s, int t, std::vector<int> & path) const
+	{
+		for (int u = t; u != -1; u = prev[u])
+			path.push_back(u);
+		std::reverse(path.begin(), path.end());
+
+		std::vector<int> jump_points;
+		jump_points.swap(path);
+		path.push_back(s);
+		for (size_t i = 1; i < jump_points.size(); i++)
+		{
+			int r = jump_points[i - 1] / cols;
+			int c = jump_points[i - 1] % cols;
+			int er = jump_points[i] / cols;
+			int ec = jump_points[i] % cols;
+			while (r != er || c != ec)
+			{
+				r += (er > r) - (er < r);
+				c += (ec > c) - (ec < c);
+				path.push_back(r * cols + c);
+			}
+		}
+	}
+
+	const GridView & grid;
+	int rows;
+	int cols;
+	JpsVariant variant;
+	int cell_cost;
+	bool usable;
+	BitGrid by_rows;
+	BitGrid by_cols;
+	std::vector<int16_t> jump_table;
+	std::vector<int> dist;
+	std::vector<int> prev;
+	std::vector<int> touched;
+};
@@ -0,0 +1,365 @@
+// Maximum Flow and Minimum Cut
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// The weights of the demo's graph file can just as well be read as
+// capacities: how much can move along each edge. Then the questions are
+// how much can be moved from s to t in all (the maximum flow) and which
+// edges, if cut, would separate t from s most cheaply (the minimum cut).
+// The two answers are equal.
+//
+// This is the push-relabel method. Every node has a height. Flow is
+// pushed only downhill, one step at a time, from nodes holding more than
+// they pass on. A node that cannot pass on its surplus is lifted until it
+// can. Two heuristics make the difference between theory and practice:
+//
+//	- Global relabeling. Every so often the height of every node is set
+//	  to its exact distance to t in the residual graph, by a breadth
+//	  first search backwards from t. Nodes that can no longer reach t are
+//	  put out of play at once.
+//	- The gap heuristic. If no node is left at some height, no node above
+//	  it can reach t any more and all of them are put out of play too.
+//
+// The node with surplus at the greatest height is always worked on next.
+//
+// The residual graph is kept as one array of arcs, grouped by the node
+// they leave, as CsrGraph does. Each edge u to v puts an arc with its
+// capacity among u's arcs and an arc of capacity zero among v's. Each
+// arc records where its partner is so pushing along one updates the
+// other. Scanning a node's arcs reads consecutive memory.
+//
+// Only the first phase of push-relabel is run: it finds the value of the
+// flow and the cut. The surplus stranded at nodes that cannot reach t is
+// not returned to s, so the arcs do not describe a flow edge by edge.
+
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+#include "GraphView.h"
+
+class MaxFlow
+{
+public:
+	// MaxFlow() - builds the residual graph. Edge weights are capacities.
+	template <GraphView G>
+	explicit MaxFlow(const G & g)
+	{
+		n = g.NodeCount();
+		first.assign(n + 1, 0);
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+			{
+				if (e.to == u)
+					continue;
+				first[u + 1]++;
+				first[e.to + 1]++;
+			}
+		}
+		for (int u = 0; u < n; u++)
+			first[u + 1] += first[u];
+
+		std::vector<int> fill(first.begin(), first.end() - 1);
+		arcs.resize(first[n]);
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+			{
+				if (e.to == u)
+					continue;
+				int a = fill[u]++;
+				int b = fill[e.to]++;
+				arcs[a] = Arc{ e.to, b, std::max(0, e.weight) };
+				arcs[b] = Arc{ u, a, 0 };
+			}
+		}
+		capacity.resize(arcs.size());
+		for (size_t a = 0; a < arcs.size(); a++)
+			capacity[a] = arcs[a].residual;
+	}
+
+	// Solve() - the maximum flow from s to t.
+	//
+	// Returns:
+	//	int64_t		- the amount of flow, which is also the capacity of
+	//				  the minimum cut.
+	int64_t Solve(int s, int t)
+	{
+		this->s = s;
+		this->t = t;
+		for (size_t a = 0; a < arcs.size(); a++)
+			arcs[a].residual = capacity[a];
+		excess.assign(n, 0);
+		height.assign(n, 0);
+		current.assign(first.begin(), first.end() - 1);
+		if (s == t)
+			return 0;
+
+		for (int a = first[s]; a < first[s + 1]; a++)
+		{
+			Arc & arc = arcs[a];
+			excess[arc.to] += arc.residual;
+			excess[s] -= arc.residual;
+			arcs[arc.rev].residual += arc.residual;
+			arc.residual = 0;
+		}
+		GlobalRelabel();
+
+		while (highest >= 0)
+		{
+			int u = active[highest];
+			if (u == -1)
+			{
+				highest--;
+				continue;
+			}
+			active[highest] = next_active[u];
+			Discharge(u);
+			if (work > (int64_t) 6 * n + (int64_t) arcs.size())
+				GlobalRelabel();
+		}
+		GlobalRelabel();
+		return excess[t];
+	}
+
+	// SourceSide() - after Solve(), true for the nodes on s's side of the
+	// minimum cut: those that can no longer reach t.
+	bool SourceSide(int v) const
+	{
+		return height[v] >= n;
+	}
+
+	// CutEdges() - after Solve(), the edges of the minimum cut as pairs of
+	// nodes. Parallel edges each give a pair, so a pair may repeat. See
+	// CutCapacity() for their total.
+	std::vector<std::pair<int, int>> CutEdges() const
+	{
+		std::vector<std::pair<int, int>> cut;
+		for (int u = 0; u < n; u++)
+		{
+			if (!SourceSide(u))
+				continue;
+			for (int a = first[u]; a < first[u + 1]; a++)
+				if (capacity[a] > 0 && !SourceSide(arcs[a].to))
+					cut.push_back(std::make_pair(u, arcs[a].to));
+		}
+		return cut;
+	}
+
+	// CutCapacity() - after Solve(), the total capacity of the edges of
+	// the minimum cut, each counted once. Equal to the maximum flow.
+	int64_t CutCapacity() const
+	{
+		int64_t total = 0;
+		for (int u = 0; u < n; u++)
+		{
+			if (!SourceSide(u))
+				continue;
+			for (int a = first[u]; a < first[u + 1]; a++)
+				if (capacity[a] > 0 && !SourceSide(arcs[a].to))
+					total += capacity[a];
+		}
+		return total;
+	}
+
+	int Relabels() const
+	{
+		return relabels;
+	}
+
+	int GlobalRelabels() const
+	{
+		return global_relabels;
+	}
+
+private:
+	struct Arc
+	{
+		int to;
+		int rev;
+		int64_t residual;
+	};
+
+	// Discharge() - pushes u's surplus downhill, lifting u when it has
+	// nowhere left to push, until the surplus is gone or u is out of play.
+	void Discharge(int u)
+	{
+		while (excess[u] > 0)
+		{
+			int end = first[u + 1];
+			int a = current[u];
+			for (; a < end && excess[u] > 0; a++)
+			{
+				Arc & arc = arcs[a];
+				if (arc.residual == 0 || height[u] != height[arc.to] + 1)
+					continue;
+				int64_t amount = std::min(excess[u], arc.residual);
+				arc.residual -= amount;
+				arcs[arc.rev].residual += amount;
+				if (excess[arc.to] == 0 && arc.to != t)
+					Activate(arc.to);
+				excess[arc.to] += amount;
+				excess[u] -= amount;
+			}
+			if (excess[u] == 0)
+			{
+				current[u] = a - 1;
+				return;
+			}
+			if (!Relabel(u))
+				return;
+		}
+	}
+
+	// Relabel() - lifts u to one above its lowest neighbor reachable by a
+	// residual arc, or applies the gap heuristic if u was the last node at
+	// its height.
+	//
+	// Returns:
+	//	bool	- false if u is now out of play.
+	bool Relabel(int u)
+	{
+		int old = height[u];
+		int lowest = 2 * n;
+		relabels++;
+		work += 12 + first[u + 1] - first[u];
+		for (int a = first[u]; a < first[u + 1]; a++)
+		{
+			if (arcs[a].residual > 0 && height[arcs[a].to] + 1 < lowest)
+			{
+				lowest = height[arcs[a].to] + 1;
+				current[u] = a;
+			}
+		}
+		Unlist(u);
+		if (all[old] == -1)
+		{
+			// Gap: nothing is left at old so nothing above it reaches t.
+			for (int h = old + 1; h <= top; h++)
+			{
+				for (int v = all[h]; v != -1; v = all_next[v])
+					height[v] = n;
+				all[h] = -1;
+				active[h] = -1;
+			}
+			top = old - 1;
+			height[u] = n;
+			return false;
+		}
+		if (lowest >= n)
+		{
+			height[u] = n;
+			return false;
+		}
+		height[u] = lowest;
+		List(u);
+		return true;
+	}
+
+	// GlobalRelabel() - sets every height to the exact distance to t in
+	// the residual graph and rebuilds the lists of nodes by height.
+	void GlobalRelabel()
+	{
+		std::vector<int> queue;
+
+		global_relabels++;
+		work = 0;
+		height.assign(n, n);
+		height[t] = 0;
+		queue.push_back(t);
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			int v = queue[i];
+			for (int a = first[v]; a < first[v + 1]; a++)
+			{
+				int u = arcs[a].to;
+				if (height[u] == n && u != s && arcs[arcs[a].rev].residual > 0)
+				{
+					height[u] = height[v] + 1;
+					queue.push_back(u);
+				}
+			}
+		}
+
+		all.assign(n, -1);
+		active.assign(n, -1);
+		all_next.assign(n, -1);
+		all_prev.assign(n, -1);
+		next_active.assign(n, -1);
+		top = highest = -1;
+		for (int v : queue)
+		{
+			current[v] = first[v];
+			List(v);
+			if (excess[v] > 0 && v != t)
+				Activate(v);
+		}
+	}
+
+	// List() - adds u to the list of nodes at its height.
+	void List(int u)
+	{
+		int h = height[u];
+		all_prev[u] = -1;
+		all_next[u] = all[h];
+		if (all[h] != -1)
+			all_prev[all[h]] = u;
+		all[h] = u;
+		top = std::max(top, h);
+	}
+
+	// Unlist() - removes u from the list of nodes at its height.
+	void Unlist(int u)
+	{
+		int h = height[u];
+		if (all_prev[u] != -1)
+			all_next[all_prev[u]] = all_next[u];
+		else
+			all[h] = all_next[u];
+		if (all_next[u] != -1)
+			all_prev[all_next[u]] = all_prev[u];
+	}
+
+	// Activate() - marks u as holding surplus. Nodes out of play are
+	// ignored: their surplus can never reach t.
+	void Activate(int u)
+	{
+		int h = height[u];
+		if (h >= n)
+			return;
+		next_active[u] = active[h];
+		active[h] = u;
+		highest = std::max(highest, h);
+	}
+
+	int n = 0;
+	int s = 0;
+	int t = 0;
+	std::vector<int> first;
+	std::vector<Arc> arcs;
+	std::vector<int64_t> capacity;
+	std::vector<int64_t> excess;
+	std::vector<int> height;
+	std::vector<int> current;
+
+	// Nodes by height: all of them (for the gap heuristic) and those
+	// holding surplus (for choosing the next to discharge).
+	std::vector<int> all;
+	std::vector<int> all_next;
+	std::vector<int> all_prev;
+	std::vector<int> active;
+	std::vector<int> next_active;
+	int top = -1;
+	int highest = -1;
+
+	int64_t work = 0;
+	int relabels = 0;
+	int global_relabels = 0;
+};
@@ -0,0 +1,439 @@
+// Minimum Cost Flow
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// MaxFlow answers how much can move from s to t. This answers how to move
+// a given amount from s to t as cheaply as possible when every edge has
+// both a capacity and a cost per unit: edge weights are the costs, and
+// capacities come from a function of the edge. With every capacity one it
+// finds the cheapest set of routes from s to t sharing no edge.
+//
+// Two methods are offered.
+//
+// Successive shortest paths: repeatedly find the cheapest route from s to
+// t in the residual graph and send as much along it as it will carry.
+// Residual arcs running backwards have negative costs, which dijkstra()
+// cannot handle. Johnson's potentials fix that: each node carries a price
+// and an arc is searched with its reduced cost, cost + price[u] -
+// price[v], which stays zero or more if after every search each node's
+// price is raised by its cost from s. The search stops as soon as t is
+// settled; raising only the settled nodes, by their cost less t's, has
+// the same effect on reduced costs as raising every node, so the nodes
+// the search never reached are not touched at all. The search's arrays
+// and heap storage belong to the solver and are reused, so a search costs
+// no allocation and no pass over every node.
+//
+// Cost scaling (Goldberg and Tarjan): prices are refined in rounds. In
+// each round every residual arc may have a reduced cost as low as -eps,
+// and the round is push-relabel over arcs of negative reduced cost. Eps
+// is divided by a constant each round. Costs are multiplied by n + 1 so
+// that eps = 1 guarantees the cheapest flow. The number of rounds grows
+// with the logarithm of the largest cost rather than with the number of
+// routes, so it catches up with successive shortest paths as instances
+// grow and need more routes. Without PriceUpdate() it never would.
+//
+// Edge costs must not be negative.
+
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <tuple>
+
+#include "GraphView.h"
+
+class MinCostFlow
+{
+public:
+	// MinCostFlow() - builds the residual graph.
+	//
+	// Parameters:
+	//	const G & g		- the graph, whose edge weights are costs per unit.
+	//	F capacity		- capacity(u, edge) gives the capacity of each edge.
+	template <GraphView G, typename F>
+	MinCostFlow(const G & g, F capacity)
+	{
+		n = g.NodeCount();
+		first.assign(n + 1, 0);
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+			{
+				if (e.to == u)
+					continue;
+				first[u + 1]++;
+				first[e.to + 1]++;
+			}
+		}
+		for (int u = 0; u < n; u++)
+			first[u + 1] += first[u];
+
+		std::vector<int> fill(first.begin(), first.end() - 1);
+		arcs.resize(first[n]);
+		limit.assign(first[n], 0);
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+			{
+				if (e.to == u)
+					continue;
+				int a = fill[u]++;
+				int b = fill[e.to]++;
+				limit[a] = std::max<int64_t>(0, capacity(u, e));
+				arcs[a] = Arc{ e.to, b, 0, e.weight };
+				arcs[b] = Arc{ u, a, 0, -e.weight };
+				largest_cost = std::max<int64_t>(largest_cost, e.weight);
+			}
+		}
+		dist.assign(n, INT64_MAX);
+		via.assign(n, -1);
+		price.assign(n, 0);
+	}
+
+	// SuccessiveShortestPaths() - sends up to amount from s to t along
+	// cheapest routes, as described at the top of this file.
+	//
+	// Parameters:
+	//	int s, t			- the source and the sink.
+	//	int64_t amount		- how much to send.
+	//	int64_t & cost		- receives the total cost.
+	// Returns:
+	//	int64_t				- how much was sent: less than amount if that
+	//						  is more than the network can carry.
+	int64_t SuccessiveShortestPaths(int s, int t, int64_t amount, int64_t & cost)
+	{
+		int64_t sent = 0;
+
+		Reset();
+		cost = 0;
+		searches = 0;
+		std::fill(price.begin(), price.end(), 0);
+		while (sent < amount && s != t && Search(s, t))
+		{
+			int64_t push = amount - sent;
+			for (int v = t; v != s; v = arcs[arcs[via[v]].rev].to)
+				push = std::min(push, arcs[via[v]].residual);
+			for (int v = t; v != s; v = arcs[arcs[via[v]].rev].to)
+			{
+				Arc & arc = arcs[via[v]];
+				arc.residual -= push;
+				arcs[arc.rev].residual += push;
+				cost += push * arc.cost;
+			}
+			sent += push;
+		}
+		return sent;
+	}
+
+	// CostScaling() - sends exactly amount from s to t as cheaply as
+	// possible by cost scaling.
+	//
+	// Parameters:
+	//	int s, t			- the source and the sink.
+	//	int64_t amount		- how much to send.
+	//	int64_t & cost		- receives the total cost.
+	// Returns:
+	//	bool				- false if the network cannot carry amount.
+	bool CostScaling(int s, int t, int64_t amount, int64_t & cost)
+	{
+		Reset();
+		cost = 0;
+		searches = 0;
+		if (s == t || amount <= 0)
+			return true;
+		scale = n + 1;
+		std::fill(price.begin(), price.end(), 0);
+		excess.assign(n, 0);
+		excess[s] = amount;
+		excess[t] = -amount;
+
+		int64_t eps = std::max<int64_t>(1, largest_cost * scale);
+		do
+		{
+			eps = std::max<int64_t>(1, eps / scaling_factor);
+			if (!Refine(eps))
+				return false;
+		} while (eps > 1);
+
+		for (int u = 0; u < n; u++)
+			for (int a = first[u]; a < first[u + 1]; a++)
+				if (limit[a] > 0)
+					cost += (limit[a] - arcs[a].residual) * arcs[a].cost;
+		return true;
+	}
+
+	// Flows() - after solving, each edge carrying flow as (from, to,
+	// amount).
+	std::vector<std::tuple<int, int, int64_t>> Flows() const
+	{
+		std::vector<std::tuple<int, int, int64_t>> flows;
+		for (int u = 0; u < n; u++)
+			for (int a = first[u]; a < first[u + 1]; a++)
+				if (limit[a] > arcs[a].residual)
+					flows.push_back(std::make_tuple(u, arcs[a].to, limit[a] - arcs[a].residual));
+		return flows;
+	}
+
+	// Searches() - the number of shortest path searches made by the last
+	// SuccessiveShortestPaths().
+	int Searches() const
+	{
+		return searches;
+	}
+
+private:
+	struct Arc
+	{
+		int to;
+		int rev;
+		int64_t residual;
+		int64_t cost;
+	};
+
+	typedef std::pair<int64_t, int> Entry;
+
+	// Reset() - every arc back to its full capacity, nothing flowing.
+	void Reset()
+	{
+		for (size_t a = 0; a < arcs.size(); a++)
+			arcs[a].residual = limit[a];
+	}
+
+	// Search() - dijkstra() over residual arcs by reduced cost, stopping
+	// when t is settled, then the price update described at the top of
+	// this file.
+	//
+	// Returns:
+	//	bool	- false if t cannot be reached.
+	bool Search(int s, int t)
+	{
+		searches++;
+		heap.clear();
+		touched.clear();
+		settled.clear();
+		dist[s] = 0;
+		touched.push_back(s);
+		heap.push_back(Entry(0, s));
+		bool found = false;
+		while (!heap.empty())
+		{
+			std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+			Entry e = heap.back();
+			heap.pop_back();
+			int u = e.second;
+			if (e.first != dist[u])
+				continue;
+			settled.push_back(u);
+			if (u == t)
+			{
+				found = true;
+				break;
+			}
+			for (int a = first[u]; a < first[u + 1]; a++)
+			{
+				const Arc & arc = arcs[a];
+				if (arc.residual == 0)
+					continue;
+				int64_t d = e.first + arc.cost + price[u] - price[arc.to];
+				if (d < dist[arc.to])
+				{
+					if (dist[arc.to] == INT64_MAX)
+						touched.push_back(arc.to);
+					dist[arc.to] = d;
+					via[arc.to] = a;
+					heap.push_back(Entry(d, arc.to));
+					std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+				}
+			}
+		}
+		if (found)
+			for (int v : settled)
+				price[v] += dist[v] - dist[t];
+		for (int v : touched)
+			dist[v] = INT64_MAX;
+		return found;
+	}
+
+	int64_t Reduced(int u, const Arc & arc) const
+	{
+		return arc.cost * scale + price[u] - price[arc.to];
+	}
+
+	// Refine() - one round of cost scaling: saturate every residual arc
+	// of negative reduced cost, then push surplus along such arcs until
+	// none is left, lowering the price of any node with surplus and
+	// nowhere to send it.
+	//
+	// Returns:
+	//	bool	- false if some surplus can never reach a node short of
+	//			  flow, meaning the amount cannot be carried.
+	bool Refine(int64_t eps)
+	{
+		for (int u = 0; u < n; u++)
+		{
+			for (int a = first[u]; a < first[u + 1]; a++)
+			{
+				Arc & arc = arcs[a];
+				if (arc.residual > 0 && Reduced(u, arc) < 0)
+				{
+					excess[u] -= arc.residual;
+					excess[arc.to] += arc.residual;
+					arcs[arc.rev].residual += arc.residual;
+					arc.residual = 0;
+				}
+			}
+		}
+
+		queue.clear();
+		for (int u = 0; u < n; u++)
+			if (excess[u] > 0)
+				queue.push_back(u);
+		if (!PriceUpdate(eps))
+			return false;
+		int relabels = 0;
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			int u = queue[i];
+			while (excess[u] > 0)
+			{
+				int a = current[u];
+				for (; a < first[u + 1] && excess[u] > 0; a++)
+				{
+					Arc & arc = arcs[a];
+					if (arc.residual == 0 || Reduced(u, arc) >= 0)
+						continue;
+					int64_t push = std::min(excess[u], arc.residual);
+					arc.residual -= push;
+					arcs[arc.rev].residual += push;
+					if (excess[arc.to] <= 0 && excess[arc.to] + push > 0)
+						queue.push_back(arc.to);
+					excess[arc.to] += push;
+					excess[u] -= push;
+				}
+				if (excess[u] == 0)
+				{
+					current[u] = a - 1;
+					break;
+				}
+
+				// Relabel: lower u's price just enough to make its best
+				// residual arc admissible.
+				int64_t best = INT64_MIN;
+				for (a = first[u]; a < first[u + 1]; a++)
+					if (arcs[a].residual > 0)
+						best = std::max(best, price[arcs[a].to] - arcs[a].cost * scale);
+				current[u] = first[u];
+				if (best == INT64_MIN)
+					return false;
+				price[u] = best - eps;
+				if (++relabels > n)
+				{
+					relabels = 0;
+					if (!PriceUpdate(eps))
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// PriceUpdate() - lowers every price at once so that each node has a
+	// path of admissible arcs to a node short of flow, where one exists.
+	// Arc u to v counts as floor(reduced cost / eps) + 1 steps of eps and a
+	// backward search from the nodes short of flow finds each node's
+	// fewest steps; its price falls by that many eps. Every residual arc
+	// keeps a reduced cost of at least -eps. Relabeling alone would get
+	// there one eps at a time.
+	//
+	// Returns:
+	//	bool	- false if a node with surplus cannot reach a node short of
+	//			  flow, meaning the amount cannot be carried.
+	bool PriceUpdate(int64_t eps)
+	{
+		int64_t longest = 0;
+
+		heap.clear();
+		touched.clear();
+		for (int v = 0; v < n; v++)
+		{
+			if (excess[v] < 0)
+			{
+				dist[v] = 0;
+				touched.push_back(v);
+				heap.push_back(Entry(0, v));
+			}
+		}
+		std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+		while (!heap.empty())
+		{
+			std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+			Entry e = heap.back();
+			heap.pop_back();
+			int v = e.second;
+			if (e.first != dist[v])
+				continue;
+			longest = e.first;
+			for (int a = first[v]; a < first[v + 1]; a++)
+			{
+				int w = arcs[a].to;
+				const Arc & back = arcs[arcs[a].rev];
+				if (back.residual == 0)
+					continue;
+				int64_t d = e.first + (Reduced(w, back) + eps) / eps;
+				if (d < dist[w])
+				{
+					if (dist[w] == INT64_MAX)
+						touched.push_back(w);
+					dist[w] = d;
+					heap.push_back(Entry(d, w));
+					std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+				}
+			}
+		}
+
+		bool reached = true;
+		for (int u = 0; u < n; u++)
+		{
+			if (dist[u] == INT64_MAX)
+			{
+				reached = reached && excess[u] <= 0;
+				price[u] -= longest * eps;
+			}
+			else
+				price[u] -= dist[u] * eps;
+		}
+		for (int v : touched)
+			dist[v] = INT64_MAX;
+		current.assign(first.begin(), first.end() - 1);
+		return reached;
+	}
+
+	static const int64_t scaling_factor = 8;
+
+	int n = 0;
+	int64_t scale = 1;
+	int64_t largest_cost = 0;
+	std::vector<int> first;
+	std::vector<Arc> arcs;
+	std::vector<int64_t> limit;
+	std::vector<int64_t> price;
+
+	// Reused by every Search().
+	std::vector<int64_t> dist;
+	std::vector<int> via;
+	std::vector<int> touched;
+	std::vector<int> settled;
+	std::vector<Entry> heap;
+	int searches = 0;
+
+	// Reused by every Refine().
+	std::vector<int64_t> excess;
+	std::vector<int> current;
+	std::vector<int> queue;
+};
@@ -0,0 +1,243 @@
+// Compressed All Pairs Next Hop Table
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Keeping previous_node for every source costs V * V ints. A router does
+// not need all of that. To travel from s to t it only needs to know the
+// first step to take from s. Having taken it, the router asks the same
+// question again of the node it arrived at. Following the next hop table
+// from node to node produces a least cost route provided every step gets
+// strictly closer to t. Any first step on a least cost route gets no
+// further from t, but with zero weight edges it may not get any closer:
+// a and b joined by an edge of weight 0 are equally far from t, and if
+// a's search happened to route through b and b's through a the router
+// would go back and forth forever. The rows are therefore computed with
+// ShortestFewestEdges (see Dijkstra.h). Among equally cheap routes it
+// always takes one with the fewest edges, so each step leaves one edge
+// fewer to go. Route() still gives up after NodeCount() steps, so a table
+// filled from other searches cannot hang it.
+//
+// For a fixed source most targets share the same first hop: a node with
+// three neighbors has only three possible answers. If the targets are
+// listed in an order where nodes that are close together in the graph are
+// close together in the list, the first hops form long runs of the same
+// value. Each source's row is therefore stored as a list of runs. A run
+// is the position in the list where it starts and the hop it holds.
+// Finding the hop for a target means a binary search for the run that
+// covers that target's position.
+//
+// The order is one depth first traversal of the whole graph shared by
+// every source, so it costs V ints in total.
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <utility>
+
+#include "GraphView.h"
+
+class NextHopTable
+{
+public:
+	// Init() - prepares to receive rows and picks the target order.
+	//
+	// Parameters:
+	//	const G & g					- the graph.
+	// Returns:
+	//	none
+	template <GraphView G>
+	void Init(const G & g)
+	{
+		n = g.NodeCount();
+		order.clear();
+		rank.assign(n, -1);
+		rows.assign(n, std::vector<Run>());
+		run_offsets.clear();
+		run_starts.clear();
+		run_hops.clear();
+
+		// Depth first preorder of every component. An explicit stack of
+		// (node, next edge to try) replaces recursion so big graphs do
+		// not overflow the call stack.
+		typedef decltype(g.OutEdges(0)) Edges;
+		typedef decltype(std::ranges::begin(std::declval<Edges &>())) EdgeIterator;
+		struct Frame
+		{
+			Edges edges;
+			EdgeIterator next;
+		};
+		std::vector<Frame> stack;
+
+		// A frame's iterator may point into the frame itself (a grid's
+		// edges are returned by value) so the stack must never move. It
+		// can never hold more than every node at once.
+		stack.reserve(n);
+		auto push = [&](int v)
+		{
+			rank[v] = (int) order.size();
+			order.push_back(v);
+			stack.push_back(Frame{ g.OutEdges(v), EdgeIterator() });
+			stack.back().next = std::ranges::begin(stack.back().edges);
+		};
+		for (int root = 0; root < n; root++)
+		{
+			if (rank[root] != -1)
+				continue;
+			push(root);
+			while (!stack.empty())
+			{
+				Frame & f = stack.back();
+				auto end = std::ranges::end(f.edges);
+				while (f.next != end && rank[(*f.next).to] != -1)
+					++f.next;
+				if (f.next == end)
+				{
+					stack.pop_back();
+					continue;
+				}
+				int v = (*f.next).to;
+				++f.next;
+				push(v);
+			}
+		}
+	}
+
+	// AddRow() - converts one source's previous_node vector into runs of
+	// first hops. Safe to call from several threads for different sources.
+	//
+	// Parameters:
+	//	int s						- the source.
+	//	const std::vector<int> & prev	- previous_node as computed from s
+	//								  by ParallelApsp<ShortestFewestEdges>().
+	// Returns:
+	//	none
+	void AddRow(int s, const std::vector<int> & prev)
+	{
+		std::vector<int> first(n, -2);
+		std::vector<int> path;
+
+		// first[t] is the hop out of s towards t. It is found by walking
+		// back along previous_node until reaching a node whose first hop
+		// is already known (or a neighbor of s, which is its own first
+		// hop) and then filling in everything walked past.
+		first[s] = s;
+		for (int t = 0; t < n; t++)
+		{
+			int u = t;
+			path.clear();
+			while (first[u] == -2)
+			{
+				if (prev[u] == -1)
+				{
+					first[u] = -1;
+					break;
+				}
+				if (prev[u] == s)
+				{
+					first[u] = u;
+					break;
+				}
+				path.push_back(u);
+				u = prev[u];
+			}
+			for (int v : path)
+				first[v] = first[u];
+		}
+
+		std::vector<Run> & runs = rows[s];
+		runs.clear();
+		for (int p = 0; p < n; p++)
+		{
+			int hop = first[order[p]];
+			if (runs.empty() || runs.back().hop != hop)
+				runs.push_back(Run{ p, hop });
+		}
+		runs.shrink_to_fit();
+	}
+
+	// Finish() - packs the per source runs into three flat arrays once all
+	// rows have been added.
+	void Finish()
+	{
+		size_t total = 0;
+		for (auto & r : rows)
+			total += r.size();
+		run_offsets.resize(n + 1);
+		run_starts.reserve(total);
+		run_hops.reserve(total);
+		for (int s = 0; s < n; s++)
+		{
+			run_offsets[s] = run_starts.size();
+			for (auto & r : rows[s])
+			{
+				run_starts.push_back(r.start);
+				run_hops.push_back(r.hop);
+			}
+			std::vector<Run>().swap(rows[s]);
+		}
+		run_offsets[n] = run_starts.size();
+	}
+
+	// Get() - the first hop from s towards t. Returns t if t is a neighbor
+	// of s on the route, s if s == t, and -1 if t cannot be reached.
+	int Get(int s, int t) const
+	{
+		const int * b = run_starts.data() + run_offsets[s];
+		const int * e = run_starts.data() + run_offsets[s + 1];
+		const int * r = std::upper_bound(b, e, rank[t]) - 1;
+		return run_hops[r - run_starts.data()];
+	}
+
+	// Route() - every node from s to t inclusive, found by following first
+	// hops. Leaves route empty if t cannot be reached from s, or if the
+	// hops go around in a circle (see above).
+	void Route(int s, int t, std::vector<int> & route) const
+	{
+		route.clear();
+		if (Get(s, t) == -1)
+			return;
+		route.push_back(s);
+		while (s != t)
+		{
+			if ((int) route.size() > n)
+			{
+				route.clear();
+				return;
+			}
+			s = Get(s, t);
+			route.push_back(s);
+		}
+	}
+
+	// Bytes() - the memory used by the finished table.
+	size_t Bytes() const
+	{
+		return (order.size() + rank.size() + run_starts.size() + run_hops.size()) * sizeof(int)
+			+ run_offsets.size() * sizeof(size_t);
+	}
+
+	size_t Runs() const
+	{
+		return run_starts.size();
+	}
+
+private:
+	struct Run
+	{
+		int start;
+		int hop;
+	};
+
+	int n = 0;
+	std::vector<int> order;
+	std::vector<int> rank;
+	std::vector<std::vector<Run>> rows;
+	std::vector<size_t> run_offsets;
+	std::vector<int> run_starts;
+	std::vector<int> run_hops;
+};
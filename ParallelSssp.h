@@ -0,0 +1,378 @@
+// Parallel Single Source Shortest Paths
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// dijkstra() settles one node at a time, which leaves nothing for a
+// second thread to do. The searches here give up that strict order in
+// return for work that can be shared.
+//
+// Bucketed search (a parallel form of Dial's algorithm): nodes are put in
+// buckets by cost, bucket i holding the costs from i * delta up to (but
+// not including) (i + 1) * delta. All nodes of the lowest bucket are
+// expanded at once, by all threads. If delta is no more than the smallest
+// edge weight, nothing expanded from a bucket can land back in it and one
+// pass per bucket suffices. With a larger delta a bucket is passed over
+// again until it stops changing.
+//
+// With small integer weights there are few buckets and each holds many
+// nodes so every pass has plenty of work. Each thread drops the nodes it
+// improves into its own private buckets, so threads never contend for a
+// shared queue. The private buckets are merged once per pass.
+//
+// Frontier search (Bellman-Ford with active sets, as graph processing
+// frameworks do it): every round, all nodes whose cost improved in the
+// previous round relax all of their edges at once. There is no ordering
+// at all, so a node may improve several times, but every round is one
+// big parallel sweep. The set of improved nodes (the "frontier") is kept
+// two ways. A list is cheap to walk when few nodes are in it. A bitmap
+// with one bit per node is cheaper once a large part of the graph is in
+// it. Each round picks whichever suits the size of its frontier.
+//
+// Both searches split their work among threads by number of edges rather
+// than number of nodes (see Partition.h). On graphs where a few nodes have
+// most of the edges, splitting by nodes would hand one thread nearly all
+// the work.
+//
+// In both searches a node's cost and previous node are packed into one 64
+// bit word which is updated with compare and swap. This keeps the two
+// consistent when several threads improve the same node at once.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <barrier>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <cstddef>
+
+#include "GraphView.h"
+#include "Partition.h"
+
+// PackedLabel() - cost in the high half, previous node in the low half.
+// Comparing packed labels compares costs first.
+inline uint64_t PackedLabel(int cost, int prev)
+{
+	return ((uint64_t) (uint32_t) cost << 32) | (uint32_t) prev;
+}
+
+// RelaxPacked() - lowers v's cost to cost (via u) if that is an
+// improvement. Returns true if it was.
+inline bool RelaxPacked(std::atomic<uint64_t> & label, int cost, int u)
+{
+	uint64_t want = PackedLabel(cost, u);
+	uint64_t have = label.load(std::memory_order_relaxed);
+	while ((have >> 32) > (uint64_t) cost)
+	{
+		if (label.compare_exchange_weak(have, want, std::memory_order_relaxed))
+			return true;
+	}
+	return false;
+}
+
+// UnpackLabels() - copies packed labels out to the usual dist and prev.
+inline void UnpackLabels(const std::vector<std::atomic<uint64_t>> & labels,
+	std::vector<int> & dist, std::vector<int> & prev)
+{
+	dist.resize(labels.size());
+	prev.resize(labels.size());
+	for (size_t v = 0; v < labels.size(); v++)
+	{
+		uint64_t l = labels[v].load(std::memory_order_relaxed);
+		dist[v] = (int) (l >> 32);
+		prev[v] = (int) (uint32_t) l;
+	}
+}
+
+// ParallelDial() - the bucketed search described above.
+//
+// Parameters:
+//	const G & g				- the graph. Weights must not be negative.
+//	int s					- the source node.
+//	int threads				- how many threads to use (0 means one per core).
+//	int delta				- the width of a bucket (0 means the smallest
+//							  edge weight, so each bucket takes one pass).
+//	std::vector<int> & dist	- receives the cost to every node.
+//	std::vector<int> & prev	- receives the previous node on each route.
+// Returns:
+//	none
+template <GraphView G>
+void ParallelDial(const G & g, int s, int threads, int delta, std::vector<int> & dist, std::vector<int> & prev)
+{
+	int n = g.NodeCount();
+	int max_weight = 0;
+	int min_weight = INT_MAX;
+
+	for (int u = 0; u < n; u++)
+	{
+		for (auto e : g.OutEdges(u))
+		{
+			max_weight = std::max(max_weight, (int) e.weight);
+			min_weight = std::min(min_weight, (int) e.weight);
+		}
+	}
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (delta <= 0)
+		delta = std::max(1, min_weight == INT_MAX ? 1 : min_weight);
+
+	// Anything added while bucket i is current lands at most
+	// max_weight / delta + 1 buckets ahead, so a ring of this many
+	// buckets per thread is enough.
+	int ring = max_weight / delta + 2;
+
+	std::vector<std::atomic<uint64_t>> labels(n);
+	for (auto & l : labels)
+		l.store(PackedLabel(INT_MAX, -1), std::memory_order_relaxed);
+	labels[s].store(PackedLabel(0, -1), std::memory_order_relaxed);
+
+	// local[t][b] is thread t's private bucket b (modulo ring).
+	std::vector<std::vector<std::vector<int>>> local(threads, std::vector<std::vector<int>>(ring));
+	std::vector<int> frontier(1, s);
+	std::vector<size_t> frontier_prefix;
+	std::vector<EdgePosition> splits;
+	std::vector<int> stamp(n, -1);
+	long long current = 0;
+	int pass = 0;
+	bool done = false;
+
+	auto cost_of = [&](int v)
+	{
+		return (int) (labels[v].load(std::memory_order_relaxed) >> 32);
+	};
+
+	// Shares the frontier out among the threads by edges.
+	auto split = [&]()
+	{
+		frontier_prefix.assign(frontier.size() + 1, 0);
+		for (size_t i = 0; i < frontier.size(); i++)
+			frontier_prefix[i + 1] = frontier_prefix[i] + (size_t) std::ranges::distance(g.OutEdges(frontier[i]));
+		splits = SplitByEdges(frontier_prefix, threads);
+	};
+	split();
+
+	// Run by one thread while the others wait at the end of each pass.
+	// Gathers the next frontier from the private buckets: first whatever
+	// was added back to the current bucket, failing that the next bucket
+	// that has anything in it. Entries whose cost has since moved to a
+	// lower bucket are stale and dropped, as are duplicates.
+	auto merge = [&]() noexcept
+	{
+		frontier.clear();
+		pass++;
+		for (int step = 0; step < ring && frontier.empty(); step++)
+		{
+			long long b = current + step;
+			for (int t = 0; t < threads; t++)
+			{
+				std::vector<int> & bucket = local[t][b % ring];
+				for (int v : bucket)
+				{
+					if (cost_of(v) / delta == b && stamp[v] != pass)
+					{
+						stamp[v] = pass;
+						frontier.push_back(v);
+					}
+				}
+				bucket.clear();
+			}
+			if (!frontier.empty())
+				current = b;
+		}
+		split();
+		done = frontier.empty();
+	};
+
+	std::barrier sync(threads, merge);
+
+	auto work = [&](int t)
+	{
+		while (true)
+		{
+			ForEachInPart(frontier_prefix, splits, t, [&](size_t i, size_t first, size_t last)
+			{
+				int u = frontier[i];
+				int du = cost_of(u);
+				auto edges = g.OutEdges(u);
+				for (auto e : EdgeSlice(edges, first, last))
+				{
+					int nd = du + e.weight;
+					if (RelaxPacked(labels[e.to], nd, u))
+						local[t][(nd / delta) % ring].push_back(e.to);
+				}
+			});
+			sync.arrive_and_wait();
+			if (done)
+				break;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(work, t));
+	work(0);
+	for (auto & w : workers)
+		w.join();
+
+	UnpackLabels(labels, dist, prev);
+}
+
+struct FrontierStats
+{
+	int rounds = 0;
+	int dense_rounds = 0;
+};
+
+// FrontierSssp() - the frontier search described above.
+//
+// Parameters:
+//	const G & g				- the graph. Weights must not be negative.
+//	int s					- the source node.
+//	int threads				- how many threads to use (0 means one per core).
+//	std::vector<int> & dist	- receives the cost to every node.
+//	std::vector<int> & prev	- receives the previous node on each route.
+//	FrontierStats * stats	- if not null, receives counts of rounds.
+// Returns:
+//	none
+template <GraphView G>
+void FrontierSssp(const G & g, int s, int threads, std::vector<int> & dist, std::vector<int> & prev,
+	FrontierStats * stats = nullptr)
+{
+	int n = g.NodeCount();
+	size_t words = ((size_t) n + 63) / 64;
+
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	// degree_prefix[u] is the number of edges leaving nodes before u.
+	std::vector<size_t> degree_prefix(n + 1, 0);
+	for (int u = 0; u < n; u++)
+		degree_prefix[u + 1] = degree_prefix[u] + (size_t) std::ranges::distance(g.OutEdges(u));
+
+	// A dense round walks the bitmap by node range. The ranges are fixed,
+	// cut so each thread's range leaves with the same number of edges.
+	std::vector<EdgePosition> dense_split = SplitByEdges(degree_prefix, threads);
+
+	std::vector<std::atomic<uint64_t>> labels(n);
+	for (auto & l : labels)
+		l.store(PackedLabel(INT_MAX, -1), std::memory_order_relaxed);
+	labels[s].store(PackedLabel(0, -1), std::memory_order_relaxed);
+
+	// next_bits has a bit set for every node improved this round. Only the
+	// thread that sets the bit adds the node to its private list, so the
+	// lists never hold a node twice.
+	std::vector<std::atomic<uint64_t>> next_bits(words);
+	std::vector<uint64_t> bits(words, 0);
+	for (auto & w : next_bits)
+		w.store(0, std::memory_order_relaxed);
+	std::vector<std::vector<int>> local(threads);
+	std::vector<int> list(1, s);
+	std::vector<size_t> list_prefix;
+	std::vector<EdgePosition> list_split;
+	bool dense = false;
+	bool done = false;
+	FrontierStats counts;
+
+	// Splits a sparse round's list among the threads by edges using the
+	// running total of its nodes' degrees.
+	auto split_list = [&]()
+	{
+		list_prefix.assign(list.size() + 1, 0);
+		for (size_t i = 0; i < list.size(); i++)
+			list_prefix[i + 1] = list_prefix[i] + degree_prefix[list[i] + 1] - degree_prefix[list[i]];
+		list_split = SplitByEdges(list_prefix, threads);
+	};
+	split_list();
+
+	auto merge = [&]() noexcept
+	{
+		size_t size = 0;
+		for (auto & l : local)
+			size += l.size();
+		counts.rounds++;
+
+		// Past about one node in twenty the bitmap is the cheaper to walk.
+		dense = size > (size_t) n / 20;
+		if (dense)
+		{
+			counts.dense_rounds++;
+			for (size_t w = 0; w < words; w++)
+				bits[w] = next_bits[w].exchange(0, std::memory_order_relaxed);
+		}
+		else
+		{
+			list.clear();
+			for (auto & l : local)
+			{
+				for (int v : l)
+				{
+					next_bits[v / 64].store(0, std::memory_order_relaxed);
+					list.push_back(v);
+				}
+			}
+			split_list();
+		}
+		for (auto & l : local)
+			l.clear();
+		done = size == 0;
+	};
+
+	std::barrier sync(threads, merge);
+
+	auto relax = [&](int t, int u, size_t first, size_t last)
+	{
+		int du = (int) (labels[u].load(std::memory_order_relaxed) >> 32);
+		auto edges = g.OutEdges(u);
+		for (auto e : EdgeSlice(edges, first, last))
+		{
+			if (RelaxPacked(labels[e.to], du + e.weight, u))
+			{
+				uint64_t bit = 1ull << (e.to % 64);
+				if (!(next_bits[e.to / 64].fetch_or(bit, std::memory_order_relaxed) & bit))
+					local[t].push_back(e.to);
+			}
+		}
+	};
+
+	auto work = [&](int t)
+	{
+		while (true)
+		{
+			if (dense)
+			{
+				ForEachInPart(degree_prefix, dense_split, t, [&](size_t u, size_t first, size_t last)
+				{
+					if ((bits[u / 64] >> (u % 64)) & 1)
+						relax(t, (int) u, first, last);
+				});
+			}
+			else
+			{
+				ForEachInPart(list_prefix, list_split, t, [&](size_t i, size_t first, size_t last)
+				{
+					relax(t, list[i], first, last);
+				});
+			}
+			sync.arrive_and_wait();
+			if (done)
+				break;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.push_back(std::thread(work, t));
+	work(0);
+	for (auto & w : workers)
+		w.join();
+
+	UnpackLabels(labels, dist, prev);
+	if (stats)
+		*stats = counts;
+}
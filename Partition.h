@@ -0,0 +1,96 @@
+// Edge Balanced Work Partitioning
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Handing each thread an equal number of nodes is fair only if nodes have
+// roughly equal numbers of edges. In many real graphs a few "hub" nodes
+// have most of the edges and the thread that draws a hub does nearly all
+// of the work while the others sit idle.
+//
+// The functions here split work by edges instead. Given the running
+// total of edges over a sequence of nodes (for a whole CSR graph that is
+// just its offsets array) each thread is handed an equal slice of the
+// edges. A slice boundary is a position: a node and an edge within that
+// node. A hub whose edges straddle a boundary is therefore shared by two
+// or more threads, each taking some of its edges.
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <cstddef>
+
+// A position within a sequence of nodes: the node's place in the sequence
+// and the number of that node's edges that come before the position.
+struct EdgePosition
+{
+	size_t item;
+	size_t edge;
+};
+
+// SplitByEdges() - cuts a sequence of nodes into parts with equal numbers
+// of edges.
+//
+// Parameters:
+//	const std::vector<size_t> & prefix	- prefix[i] is the number of edges
+//										  belonging to items before i. It has
+//										  one more entry than there are items.
+//	int parts							- how many parts to cut.
+// Returns:
+//	std::vector<EdgePosition>			- parts + 1 positions. Part t runs
+//										  from position t up to position t + 1.
+inline std::vector<EdgePosition> SplitByEdges(const std::vector<size_t> & prefix, int parts)
+{
+	std::vector<EdgePosition> splits(parts + 1);
+	size_t items = prefix.size() - 1;
+	size_t total = prefix.back();
+
+	for (int t = 0; t < parts; t++)
+	{
+		size_t target = total * t / parts;
+
+		// The last item starting at or before target (skipping items with
+		// no edges, which would otherwise soak up the boundary).
+		size_t i = std::upper_bound(prefix.begin(), prefix.end(), target) - prefix.begin() - 1;
+		if (i >= items)
+			i = items;
+		splits[t] = EdgePosition{ i, target - prefix[i] };
+	}
+	splits[0] = EdgePosition{ 0, 0 };
+	splits[parts] = EdgePosition{ items, 0 };
+	return splits;
+}
+
+// ForEachInPart() - calls f(i, first, last) for every item of part t
+// giving the item's edges, first up to (not including) last, that belong
+// to the part.
+template <typename F>
+void ForEachInPart(const std::vector<size_t> & prefix, const std::vector<EdgePosition> & splits, int t, F f)
+{
+	EdgePosition from = splits[t];
+	EdgePosition to = splits[t + 1];
+
+	for (size_t i = from.item; i < to.item || (i == to.item && to.edge > 0); i++)
+	{
+		size_t first = i == from.item ? from.edge : 0;
+		size_t last = i == to.item ? to.edge : prefix[i + 1] - prefix[i];
+		if (first < last)
+			f(i, first, last);
+	}
+}
+
+// EdgeSlice() - edges first up to last of a node's out edge range. For
+// CSR (and any other random access range) this costs nothing. For other
+// ranges it steps past the first edges. The range must outlive the slice
+// (a grid's edges are returned by value) so it is taken by reference.
+template <typename R>
+auto EdgeSlice(R & edges, size_t first, size_t last)
+{
+	auto b = std::ranges::next(std::ranges::begin(edges), (std::ptrdiff_t) first);
+	auto e = std::ranges::next(b, (std::ptrdiff_t) (last - first));
+	return std::ranges::subrange(b, e);
+}
@@ -0,0 +1,197 @@
+// Streaming Path Output
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// PrintRoutes() prints only the cost and previous node of every node.
+// PathWriter writes whole routes: for each requested target, every node
+// from the source to the target with the cost of the edge leading to it
+// and the cost so far. Routes are read straight out of the dist and prev
+// arrays left by any search. The cost of the edge into v is simply
+// dist[v] - dist[prev[v]], so the graph is not consulted.
+//
+// Output goes through one buffer that is flushed when full. No container
+// is built per route, so writing millions of routes costs no allocation.
+//
+// Two encodings are offered:
+//
+//	path_json	{"source":s,"paths":[{"target":t,"cost":c,"steps":
+//				[[node,edge cost,cost so far],...]},...]}
+//				An unreachable target has "cost":null and no steps.
+//	path_binary	(all values 32 bit, as written by the host)
+//				magic "DPS1", source, then for each target: target,
+//				number of steps (0 if unreachable), then each step as
+//				node, edge cost, cost so far. A target of -1 ends the
+//				stream.
+//
+// A route is found by walking prev from the target back to the source,
+// which gives its nodes last to first. The binary encoding knows the
+// size of each step, so it measures the route first and fills its room
+// in the buffer from the back. The JSON encoding keeps one scratch array
+// of nodes, reused for every route.
+
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+enum PathFormat { path_json, path_binary };
+
+const uint32_t path_stream_magic = 0x31535044;	// "DPS1"
+
+class PathWriter
+{
+public:
+	PathWriter(std::ostream & out, PathFormat format) : out(out), format(format), buffer(1 << 16)
+	{
+	}
+
+	~PathWriter()
+	{
+		Flush();
+	}
+
+	// Begin() - starts the routes from one source.
+	void Begin(int source)
+	{
+		first = true;
+		if (format == path_json)
+		{
+			Text("{\"source\":");
+			Number(source);
+			Text(",\"paths\":[");
+		}
+		else
+		{
+			Word(path_stream_magic);
+			Word(source);
+		}
+	}
+
+	// Write() - writes the route to one target.
+	//
+	// Parameters:
+	//	int target			- the target.
+	//	const int * dist	- the cost to every node.
+	//	const int * prev	- the previous node on the route to every node.
+	void Write(int target, const int * dist, const int * prev)
+	{
+		bool reachable = dist[target] != INT_MAX;
+		size_t steps = 0;
+		if (reachable)
+			for (int v = target; v != -1; v = prev[v])
+				steps++;
+
+		if (format == path_binary)
+		{
+			Word(target);
+			Word((uint32_t) steps);
+			size_t size = steps * 3 * sizeof(int32_t);
+			char * end = Room(size) + size;
+			for (int v = target; reachable && v != -1; v = prev[v])
+			{
+				int32_t step[3] = { v, prev[v] == -1 ? 0 : dist[v] - dist[prev[v]], dist[v] };
+				end -= sizeof(step);
+				memcpy(end, step, sizeof(step));
+			}
+			return;
+		}
+
+		Text(first ? "{\"target\":" : ",{\"target\":");
+		first = false;
+		Number(target);
+		if (!reachable)
+		{
+			Text(",\"cost\":null,\"steps\":[]}");
+			return;
+		}
+		Text(",\"cost\":");
+		Number(dist[target]);
+		Text(",\"steps\":[");
+		scratch.clear();
+		for (int v = target; v != -1; v = prev[v])
+			scratch.push_back(v);
+		for (size_t i = scratch.size(); i-- > 0; )
+		{
+			int v = scratch[i];
+			Text(i + 1 == scratch.size() ? "[" : ",[");
+			Number(v);
+			Text(",");
+			Number(prev[v] == -1 ? 0 : dist[v] - dist[prev[v]]);
+			Text(",");
+			Number(dist[v]);
+			Text("]");
+		}
+		Text("]}");
+	}
+
+	// End() - finishes the routes from the current source.
+	void End()
+	{
+		if (format == path_json)
+			Text("]}\n");
+		else
+			Word(-1);
+		Flush();
+	}
+
+private:
+	// Room() - makes room for size bytes at the end of the buffer and
+	// returns where they start. Only a route too long for the buffer
+	// makes the buffer grow, and it stays grown.
+	char * Room(size_t size)
+	{
+		if (used + size > buffer.size())
+		{
+			Flush();
+			if (size > buffer.size())
+				buffer.resize(size);
+		}
+		char * p = buffer.data() + used;
+		used += size;
+		return p;
+	}
+
+	void Text(const char * s)
+	{
+		size_t n = strlen(s);
+		memcpy(Room(n), s, n);
+	}
+
+	void Number(int v)
+	{
+		char digits[12];
+		auto r = std::to_chars(digits, digits + sizeof(digits), v);
+		size_t n = r.ptr - digits;
+		memcpy(Room(n), digits, n);
+	}
+
+	void Word(int32_t v)
+	{
+		memcpy(Room(sizeof(v)), &v, sizeof(v));
+	}
+
+	void Word(uint32_t v)
+	{
+		memcpy(Room(sizeof(v)), &v, sizeof(v));
+	}
+
+	void Flush()
+	{
+		out.write(buffer.data(), used);
+		used = 0;
+	}
+
+	std::ostream & out;
+	PathFormat format;
+	std::vector<char> buffer;
+	size_t used = 0;
+	bool first = true;
+	std::vector<int> scratch;
+};
@@ -0,0 +1,183 @@
+// Progressive Graph Loading
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Reading a huge graph file can take minutes. Rather than make every
+// query wait for the whole file, ProgressiveGraph reads the file on a
+// loader thread in regions of consecutive rows and publishes each region
+// the moment it is complete. It is a GraphView, so any search can run on
+// it while loading continues. A search only waits when it asks for the
+// edges of a node whose region has not arrived yet, and then only until
+// that region arrives. A point to point query near the start of the file
+// is answered long before the end of the file is read.
+//
+// The file is in the demo's format: the number of nodes followed by the
+// full matrix of costs, row by row, with -1 meaning no edge. Each row is
+// kept only as the edges it actually has. The file may be compressed (see
+// ByteSource.h).
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+#include "GraphView.h"
+#include "ByteSource.h"
+
+// ProgressiveGraph - a GraphView whose regions arrive while it is used.
+class ProgressiveGraph
+{
+public:
+	~ProgressiveGraph()
+	{
+		if (loader.joinable())
+			loader.join();
+	}
+
+	// Start() - opens a graph file, reads the number of nodes and starts
+	// the loader thread.
+	//
+	// Parameters:
+	//	const std::string & path	- the graph file.
+	//	int rows_per_region			- rows published together. Zero picks
+	//								  regions of about a million costs.
+	//	std::string * problem		- if not null, receives the reason for
+	//								  failure.
+	// Returns:
+	//	bool						- false if the file could not be opened
+	//								  or does not start with a node count.
+	bool Start(const std::string & path, int rows_per_region = 0, std::string * problem = nullptr)
+	{
+		source = OpenByteSource(path, problem);
+		if (!source)
+			return false;
+		reader.reset(new TextIntReader(*source));
+		if (!reader->Next(n) || n <= 0)
+		{
+			if (problem)
+				*problem = path + " does not start with a node count";
+			return false;
+		}
+
+		region_rows = rows_per_region > 0 ? rows_per_region : std::max(1, (1 << 20) / n);
+		regions.resize((n + region_rows - 1) / region_rows);
+		loader = std::thread(&ProgressiveGraph::Load, this);
+		return true;
+	}
+
+	int NodeCount() const
+	{
+		return n;
+	}
+
+	// OutEdges() - the edges of u, waiting for u's region if need be. If
+	// the file ended early, rows from the incomplete region on have no
+	// edges.
+	std::span<const Edge> OutEdges(int u) const
+	{
+		int r = u / region_rows;
+		if (r >= loaded.load(std::memory_order_acquire))
+			WaitFor(r);
+		const Region & region = regions[r];
+		if (region.offsets.empty())
+			return std::span<const Edge>();
+		int i = u - r * region_rows;
+		return std::span<const Edge>(region.edges.data() + region.offsets[i], region.edges.data() + region.offsets[i + 1]);
+	}
+
+	int RegionCount() const
+	{
+		return (int) regions.size();
+	}
+
+	int RegionsLoaded() const
+	{
+		return loaded.load(std::memory_order_acquire);
+	}
+
+	// Finish() - waits for the loader. Returns false if the file was not
+	// well formed.
+	bool Finish()
+	{
+		if (loader.joinable())
+			loader.join();
+		return !failed;
+	}
+
+private:
+	struct Region
+	{
+		std::vector<size_t> offsets;
+		std::vector<Edge> edges;
+	};
+
+	// Load() - the loader thread. Regions are filled in before they are
+	// published so readers never see one being built.
+	void Load()
+	{
+		for (int r = 0; r < (int) regions.size() && !failed; r++)
+		{
+			Region & region = regions[r];
+			int first = r * region_rows;
+			int last = std::min(n, first + region_rows);
+			region.offsets.assign(1, 0);
+			for (int u = first; u < last && !failed; u++)
+			{
+				for (int v = 0; v < n; v++)
+				{
+					int c;
+					if (!reader->Next(c))
+					{
+						failed = true;
+						break;
+					}
+					if (c != -1)
+						region.edges.push_back(Edge{ v, c });
+				}
+				region.offsets.push_back(region.edges.size());
+			}
+			if (failed)
+				region.offsets.clear();
+			Publish(r + 1);
+		}
+		Publish((int) regions.size());
+		reader.reset();
+		source.reset();
+	}
+
+	void Publish(int count)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			loaded.store(count, std::memory_order_release);
+		}
+		arrived.notify_all();
+	}
+
+	void WaitFor(int r) const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		arrived.wait(lock, [&]() { return loaded.load(std::memory_order_acquire) > r; });
+	}
+
+	int n = 0;
+	int region_rows = 1;
+	std::vector<Region> regions;
+	std::atomic<int> loaded{ 0 };
+	bool failed = false;
+	mutable std::mutex mutex;
+	mutable std::condition_variable arrived;
+	std::unique_ptr<ByteSource> source;
+	std::unique_ptr<TextIntReader> reader;
+	std::thread loader;
+};
@@ -0,0 +1,334 @@
+// Reachability Index
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Many questions are only "can t be reached from s at all?". dijkstra()
+// answers by searching until it settles t, or until it has settled
+// everything when t cannot be reached, which is the slow case. This index
+// answers most such questions by comparing a few numbers.
+//
+// First the graph is condensed. Nodes that can all reach one another (a
+// strongly connected component) are merged into one, found by Tarjan's
+// algorithm. s reaches t when they are in the same component or s's
+// component reaches t's. What is left has no cycles (a DAG). Tarjan's
+// algorithm finishes a component only after every component it reaches,
+// so component numbers fall along every edge of the DAG: a component can
+// only reach components with smaller numbers.
+//
+// Then each component is given intervals (GRAIL, by Yildirim, Chaoji and
+// Zaki). A depth first search of the DAG numbers components in the order
+// it finishes them. A component's interval runs from the smallest number
+// of anything it reaches to its own number. If u reaches v then v's
+// interval lies within u's. The reverse does not hold, but it very often
+// fails to hold for some of several searches made in different random
+// orders, and one failure proves v cannot be reached. Each search also
+// proves some pairs reachable: everything below u in the search's own
+// tree. Only when neither settles it is a search of the DAG needed, and
+// that search skips every component whose intervals rule it out and
+// stops at the first component proved to reach v.
+//
+// The index takes a handful of numbers per node no matter how many nodes
+// each can reach, unlike the full closure (see AlgebraicPaths.h), which
+// takes n * n bits.
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include "GraphView.h"
+
+class ReachabilityIndex
+{
+public:
+	// Build() - condenses the graph and labels the components.
+	//
+	// Parameters:
+	//	const G & g		- the graph.
+	//	int labels		- how many interval labels per component.
+	//	unsigned seed	- for the random orders of the searches.
+	template <GraphView G>
+	void Build(const G & g, int labels = 3, unsigned seed = 1)
+	{
+		int n = g.NodeCount();
+		std::vector<size_t> offsets(n + 1, 0);
+		std::vector<int> targets;
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+				targets.push_back(e.to);
+			offsets[u + 1] = targets.size();
+		}
+		Condense(n, offsets, targets);
+		Label(labels, seed);
+		stamp.assign(components, 0);
+		visit = 0;
+	}
+
+	// Reaches() - true if t can be reached from s. Uses scratch space in
+	// the index, so one thread at a time.
+	bool Reaches(int s, int t)
+	{
+		int cs = component[s];
+		int ct = component[t];
+		if (cs == ct)
+			return true;
+		if (!MayReach(cs, ct))
+			return false;
+		if (MustReach(cs, ct))
+			return true;
+
+		// The intervals cannot rule it out: search the DAG, skipping
+		// anything that they do rule out.
+		if (++visit == 0)
+		{
+			std::fill(stamp.begin(), stamp.end(), 0);
+			visit = 1;
+		}
+		searches++;
+		work.clear();
+		work.push_back(cs);
+		stamp[cs] = visit;
+		while (!work.empty())
+		{
+			int c = work.back();
+			work.pop_back();
+			// Children are stored by increasing number. Pushing them in
+			// reverse means the one with the smallest number, the one
+			// furthest along toward the sinks, is searched first.
+			for (size_t a = dag_offsets[c + 1]; a-- > dag_offsets[c]; )
+			{
+				int d = dag[a];
+				if (d == ct || MustReach(d, ct))
+					return true;
+				if (stamp[d] == visit || !MayReach(d, ct))
+					continue;
+				stamp[d] = visit;
+				work.push_back(d);
+			}
+		}
+		return false;
+	}
+
+	int Components() const
+	{
+		return components;
+	}
+
+	int ComponentOf(int v) const
+	{
+		return component[v];
+	}
+
+	// Searches() - how many queries so far could not be answered from
+	// the intervals alone.
+	int64_t Searches() const
+	{
+		return searches;
+	}
+
+	// Bytes() - the memory taken by the index.
+	size_t Bytes() const
+	{
+		return component.size() * sizeof(int) + dag_offsets.size() * sizeof(size_t) +
+			dag.size() * sizeof(int) + intervals.size() * sizeof(Interval) + stamp.size() * sizeof(uint32_t);
+	}
+
+private:
+	// low to high is the GRAIL interval. tree to high holds the numbers of
+	// the components below this one in the search's own tree.
+	struct Interval
+	{
+		int low;
+		int high;
+		int tree;
+	};
+
+	// MayReach() - false if some interval of d is not within c's, which
+	// proves c cannot reach d. Component numbers fall along every edge so
+	// a smaller number cannot reach a larger one either.
+	bool MayReach(int c, int d) const
+	{
+		if (c < d)
+			return false;
+		const Interval * ic = &intervals[(size_t) c * k];
+		const Interval * id = &intervals[(size_t) d * k];
+		for (int i = 0; i < k; i++)
+			if (id[i].low < ic[i].low || id[i].high > ic[i].high)
+				return false;
+		return true;
+	}
+
+	// MustReach() - true if d is below c in the tree of some search, which
+	// proves c reaches d.
+	bool MustReach(int c, int d) const
+	{
+		const Interval * ic = &intervals[(size_t) c * k];
+		const Interval * id = &intervals[(size_t) d * k];
+		for (int i = 0; i < k; i++)
+			if (id[i].high >= ic[i].tree && id[i].high <= ic[i].high)
+				return true;
+		return false;
+	}
+
+	// Condense() - Tarjan's algorithm without recursion, then the edges
+	// between different components, each kept once.
+	void Condense(int n, const std::vector<size_t> & offsets, const std::vector<int> & targets)
+	{
+		std::vector<int> index(n, -1), low(n, 0);
+		std::vector<char> on_stack(n, 0);
+		std::vector<int> stack;
+		std::vector<std::pair<int, size_t>> calls;
+		int next = 0;
+
+		component.assign(n, -1);
+		components = 0;
+		for (int root = 0; root < n; root++)
+		{
+			if (index[root] != -1)
+				continue;
+			calls.push_back(std::make_pair(root, offsets[root]));
+			index[root] = low[root] = next++;
+			stack.push_back(root);
+			on_stack[root] = 1;
+			while (!calls.empty())
+			{
+				int u = calls.back().first;
+				size_t & a = calls.back().second;
+				if (a < offsets[u + 1])
+				{
+					int v = targets[a++];
+					if (index[v] == -1)
+					{
+						index[v] = low[v] = next++;
+						stack.push_back(v);
+						on_stack[v] = 1;
+						calls.push_back(std::make_pair(v, offsets[v]));
+					}
+					else if (on_stack[v])
+						low[u] = std::min(low[u], index[v]);
+					continue;
+				}
+				calls.pop_back();
+				if (!calls.empty())
+				{
+					int parent = calls.back().first;
+					low[parent] = std::min(low[parent], low[u]);
+				}
+				if (low[u] == index[u])
+				{
+					int v;
+					do
+					{
+						v = stack.back();
+						stack.pop_back();
+						on_stack[v] = 0;
+						component[v] = components;
+					} while (v != u);
+					components++;
+				}
+			}
+		}
+
+		std::vector<std::pair<int, int>> pairs;
+		for (int u = 0; u < n; u++)
+			for (size_t a = offsets[u]; a < offsets[u + 1]; a++)
+				if (component[u] != component[targets[a]])
+					pairs.push_back(std::make_pair(component[u], component[targets[a]]));
+		std::sort(pairs.begin(), pairs.end());
+		pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+		dag_offsets.assign(components + 1, 0);
+		dag.resize(pairs.size());
+		for (size_t i = 0; i < pairs.size(); i++)
+		{
+			dag_offsets[pairs[i].first + 1]++;
+			dag[i] = pairs[i].second;
+		}
+		for (int c = 0; c < components; c++)
+			dag_offsets[c + 1] += dag_offsets[c];
+	}
+
+	// Label() - k depth first searches of the DAG, each visiting roots and
+	// children in a different random order, giving each component one
+	// interval per search.
+	void Label(int labels, unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<int> children(dag);
+		std::vector<int> roots;
+		std::vector<char> has_parent(components, 0);
+		std::vector<char> seen(components);
+		std::vector<std::pair<int, size_t>> calls;
+
+		k = std::max(1, labels);
+		intervals.assign((size_t) components * k, Interval{ 0, 0, 0 });
+		for (int d : dag)
+			has_parent[d] = 1;
+		for (int c = 0; c < components; c++)
+			if (!has_parent[c])
+				roots.push_back(c);
+
+		for (int i = 0; i < k; i++)
+		{
+			std::shuffle(roots.begin(), roots.end(), rng);
+			for (int c = 0; c < components; c++)
+				std::shuffle(children.begin() + dag_offsets[c], children.begin() + dag_offsets[c + 1], rng);
+			std::fill(seen.begin(), seen.end(), 0);
+			int finished = 0;
+			for (int root : roots)
+			{
+				calls.push_back(std::make_pair(root, dag_offsets[root]));
+				seen[root] = 1;
+				intervals[(size_t) root * k + i].low = components;
+				intervals[(size_t) root * k + i].tree = finished;
+				while (!calls.empty())
+				{
+					int c = calls.back().first;
+					size_t & a = calls.back().second;
+					Interval & ic = intervals[(size_t) c * k + i];
+					if (a < dag_offsets[c + 1])
+					{
+						int d = children[a++];
+						if (!seen[d])
+						{
+							seen[d] = 1;
+							intervals[(size_t) d * k + i].low = components;
+							intervals[(size_t) d * k + i].tree = finished;
+							calls.push_back(std::make_pair(d, dag_offsets[d]));
+						}
+						else
+							ic.low = std::min(ic.low, intervals[(size_t) d * k + i].low);
+						continue;
+					}
+					ic.high = finished++;
+					ic.low = std::min(ic.low, ic.high);
+					calls.pop_back();
+					if (!calls.empty())
+					{
+						Interval & parent = intervals[(size_t) calls.back().first * k + i];
+						parent.low = std::min(parent.low, ic.low);
+					}
+				}
+			}
+		}
+	}
+
+	int k = 1;
+	int components = 0;
+	std::vector<int> component;
+	std::vector<size_t> dag_offsets;
+	std::vector<int> dag;
+	std::vector<Interval> intervals;
+
+	// Scratch space for Reaches().
+	std::vector<uint32_t> stamp;
+	uint32_t visit = 0;
+	std::vector<int> work;
+	int64_t searches = 0;
+};
@@ -0,0 +1,320 @@
+// Shared Memory Graph Segment
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// When many worker processes on one machine each read the graph file they
+// each hold their own copy of the same graph. Instead, one loader process
+// can place a CSR image of the graph in a POSIX shared memory object
+// (shm_open()) and the workers map that object read only. The operating
+// system keeps a single copy no matter how many workers attach, and
+// attaching costs one mmap() and one pass to check the image rather than
+// a parse of the file.
+//
+// The object outlives the loader. It stays until RemoveSharedGraph() (or
+// a reboot) removes it, so workers may come and go freely.
+//
+// Layout of the image (all values as written by the host):
+//
+//	Header		magic, number of nodes, number of edges, where the
+//				arrays start and the size of the whole image
+//	Offsets		NodeCount() + 1 64 bit offsets, as in CsrGraph
+//	Edges		EdgeCount() Edge structures
+//
+// The loader writes the magic number last. A worker that finds the right
+// magic number therefore finds a complete image.
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <ranges>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <climits>
+#include <atomic>
+#include <algorithm>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "GraphView.h"
+
+const uint32_t graph_image_magic = 0x31494744;	// "DGI1"
+
+struct GraphImageHeader
+{
+	uint32_t magic;
+	uint32_t reserved;
+	uint64_t nodes;
+	uint64_t edges;
+	uint64_t offsets_at;
+	uint64_t edges_at;
+	uint64_t size;
+};
+
+// GraphImageLayout() - fills in everything but the magic number of the
+// header of an image holding the given numbers of nodes and edges.
+inline GraphImageHeader GraphImageLayout(uint64_t nodes, uint64_t edges)
+{
+	GraphImageHeader h;
+	memset(&h, 0, sizeof(h));
+	h.nodes = nodes;
+	h.edges = edges;
+	h.offsets_at = sizeof(GraphImageHeader);
+	h.edges_at = h.offsets_at + (nodes + 1) * sizeof(uint64_t);
+	h.size = h.edges_at + edges * sizeof(Edge);
+	return h;
+}
+
+// GraphImageValid() - checks that a header describes an image that fits
+// in size bytes.
+inline bool GraphImageValid(const GraphImageHeader & h, uint64_t size)
+{
+	GraphImageHeader expected = GraphImageLayout(h.nodes, h.edges);
+	return h.magic == graph_image_magic && h.nodes < INT_MAX && h.offsets_at == expected.offsets_at &&
+		h.edges_at == expected.edges_at && h.size == expected.size && h.size <= size;
+}
+
+// GraphImageChecker - checks an image as it arrives: the offsets never
+// decrease and end at the number of edges, and every edge leads to a node
+// that exists. Each call to Check() looks only at what has arrived since
+// the last call. An image already in memory is checked by one call.
+class GraphImageChecker
+{
+public:
+	explicit GraphImageChecker(uint64_t size) : size(size)
+	{
+	}
+
+	// Check() - checks the image as far as its first ready bytes allow.
+	// Returns false as soon as anything is wrong.
+	bool Check(const char * image, uint64_t ready)
+	{
+		if (!ok)
+			return false;
+		if (!have_header)
+		{
+			if (ready < sizeof(h))
+				return true;
+			memcpy(&h, image, sizeof(h));
+			ok = GraphImageValid(h, size) && h.size == size;
+			have_header = true;
+			if (!ok)
+				return false;
+		}
+
+		const uint64_t * offsets = (const uint64_t *) (image + h.offsets_at);
+		uint64_t offsets_ready = ready > h.offsets_at ? std::min(h.nodes + 1, (ready - h.offsets_at) / sizeof(uint64_t)) : 0;
+		for (; next_offset < offsets_ready && ok; next_offset++)
+		{
+			uint64_t o = offsets[next_offset];
+			ok = next_offset == 0 ? o == 0 : o >= last_offset && o <= h.edges;
+			ok = ok && (next_offset < h.nodes || o == h.edges);
+			last_offset = o;
+		}
+
+		const Edge * edges = (const Edge *) (image + h.edges_at);
+		uint64_t edges_ready = ready > h.edges_at ? std::min(h.edges, (ready - h.edges_at) / sizeof(Edge)) : 0;
+		for (; next_edge < edges_ready && ok; next_edge++)
+			ok = edges[next_edge].to >= 0 && (uint64_t) edges[next_edge].to < h.nodes && edges[next_edge].weight >= 0;
+		return ok;
+	}
+
+	// Complete() - true once the whole image has been checked and passed.
+	bool Complete() const
+	{
+		return ok && have_header && next_offset == h.nodes + 1 && next_edge == h.edges;
+	}
+
+private:
+	uint64_t size;
+	GraphImageHeader h;
+	bool have_header = false;
+	bool ok = true;
+	uint64_t next_offset = 0;
+	uint64_t next_edge = 0;
+	uint64_t last_offset = 0;
+};
+
+// WriteGraphImage() - writes the image of any view into memory already
+// sized by GraphImageLayout(). The edges are copied straight from the
+// view with no intermediate CsrGraph.
+template <GraphView G>
+void WriteGraphImage(const G & g, char * image, const GraphImageHeader & h)
+{
+	uint64_t * offsets = (uint64_t *) (image + h.offsets_at);
+	Edge * edges = (Edge *) (image + h.edges_at);
+	uint64_t count = 0;
+
+	offsets[0] = 0;
+	for (int u = 0; u < (int) h.nodes; u++)
+	{
+		for (auto e : g.OutEdges(u))
+			edges[count++] = Edge{ e.to, e.weight };
+		offsets[u + 1] = count;
+	}
+
+	GraphImageHeader done = h;
+	done.magic = 0;
+	memcpy(image, &done, sizeof(done));
+	std::atomic_thread_fence(std::memory_order_release);
+	((GraphImageHeader *) image)->magic = graph_image_magic;
+}
+
+// PublishSharedGraph() - creates a shared memory object holding the
+// image of a graph.
+//
+// Parameters:
+//	const G & g				- the graph.
+//	const std::string & name	- the object's name, such as "/roads".
+// Returns:
+//	bool					- false if the object already exists or
+//							  could not be created.
+template <GraphView G>
+bool PublishSharedGraph(const G & g, const std::string & name)
+{
+	uint64_t edges = 0;
+	for (int u = 0; u < g.NodeCount(); u++)
+		edges += (uint64_t) std::ranges::distance(g.OutEdges(u));
+	GraphImageHeader h = GraphImageLayout(g.NodeCount(), edges);
+
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0)
+		return false;
+	if (ftruncate(fd, (off_t) h.size) != 0)
+	{
+		close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	void * image = mmap(nullptr, h.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED)
+	{
+		shm_unlink(name.c_str());
+		return false;
+	}
+	WriteGraphImage(g, (char *) image, h);
+	munmap(image, h.size);
+	return true;
+}
+
+// RemoveSharedGraph() - removes a shared memory object. Workers already
+// attached keep their mapping until they detach.
+inline bool RemoveSharedGraph(const std::string & name)
+{
+	return shm_unlink(name.c_str()) == 0;
+}
+
+// GraphImage - a GraphView over a complete image somewhere in memory. Its
+// OutEdges() are spans just like CsrGraph's, so every algorithm runs on
+// it unchanged.
+class GraphImage
+{
+public:
+	// Bind() - checks the header of the image at base and views it.
+	bool Bind(const char * base, uint64_t size)
+	{
+		GraphImageHeader h;
+		if (size < sizeof(h))
+			return false;
+		memcpy(&h, base, sizeof(h));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!GraphImageValid(h, size))
+			return false;
+		n = (int) h.nodes;
+		offsets = (const uint64_t *) (base + h.offsets_at);
+		edges = (const Edge *) (base + h.edges_at);
+		return true;
+	}
+
+	int NodeCount() const
+	{
+		return n;
+	}
+
+	size_t EdgeCount() const
+	{
+		return n == 0 ? 0 : offsets[n];
+	}
+
+	std::span<const Edge> OutEdges(int u) const
+	{
+		return std::span<const Edge>(edges + offsets[u], edges + offsets[u + 1]);
+	}
+
+protected:
+	int n = 0;
+	const uint64_t * offsets = nullptr;
+	const Edge * edges = nullptr;
+};
+
+// SharedGraph - a read only mapping of a graph image in shared memory.
+class SharedGraph : public GraphImage
+{
+public:
+	SharedGraph() = default;
+	SharedGraph(const SharedGraph &) = delete;
+	SharedGraph & operator=(const SharedGraph &) = delete;
+
+	~SharedGraph()
+	{
+		Detach();
+	}
+
+	// Attach() - maps a published graph.
+	//
+	// Parameters:
+	//	const std::string & name	- the name given to PublishSharedGraph().
+	// Returns:
+	//	bool						- false if there is no such object or
+	//								  it does not hold a complete image.
+	bool Attach(const std::string & name)
+	{
+		Detach();
+		int fd = shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || (uint64_t) st.st_size < sizeof(GraphImageHeader))
+		{
+			close(fd);
+			return false;
+		}
+		void * image = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (image == MAP_FAILED)
+			return false;
+		base = (const char *) image;
+		size = st.st_size;
+		// Any process able to open the object for writing could have put
+		// anything in it, so the offsets and edges are checked as a loaded
+		// file's are before anything follows them.
+		GraphImageChecker checker(size);
+		if (!checker.Check(base, size) || !checker.Complete() || !Bind(base, size))
+		{
+			Detach();
+			return false;
+		}
+		return true;
+	}
+
+	// Detach() - unmaps the graph. The object itself remains.
+	void Detach()
+	{
+		if (base != nullptr)
+			munmap((void *) base, size);
+		base = nullptr;
+		size = 0;
+		n = 0;
+	}
+
+private:
+	const char * base = nullptr;
+	size_t size = 0;
+};
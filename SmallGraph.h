@@ -0,0 +1,151 @@
+// Compile Time Dijkstra for Small Fixed Graphs
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// When a graph is small and never changes (think of a controller with a
+// handful of fixed links) there is no reason to read it from a file or
+// even to run dijkstra() while the program runs. Here the number of
+// nodes is a template parameter so every array has a size known to the
+// compiler:
+//
+//	- the graph and the results live in std::array instead of vector.
+//	- the unvisited set of the README's algorithm becomes the bits of a
+//	  single 64 bit integer.
+//	- the loop over neighbors is unrolled by the compiler because its
+//	  length is a constant.
+//	- everything is constexpr, so routing tables for a known graph can be
+//	  computed by the compiler and stored in the program as constants.
+//
+// The search is the original O(N * N) form of the algorithm. For a dozen
+// nodes a scan over a 64 bit mask beats any priority queue.
+
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <utility>
+
+template <int N>
+struct SmallGraph
+{
+	static_assert(N > 0 && N <= 64, "The unvisited set is a 64 bit mask.");
+
+	// Same layout as graph in Source.cpp: row u, column v, -1 for no edge.
+	std::array<int, N * N> cost;
+
+	constexpr int Get(int u, int v) const
+	{
+		return cost[N * u + v];
+	}
+};
+
+template <int N>
+struct SmallRoutes
+{
+	std::array<int, N> dist;
+	std::array<int, N> previous_node;
+};
+
+// SmallRelax() - considers the edge from u to node V. The node number is
+// a template parameter so the compiler sees N separate straight line
+// copies of this rather than a loop.
+template <int N, int V>
+constexpr void SmallRelax(const SmallGraph<N> & g, SmallRoutes<N> & r, uint64_t unvisited, int u)
+{
+	int c = g.Get(u, V);
+	if (c != -1 && (unvisited >> V) & 1)
+	{
+		int newDist = r.dist[u] + c;
+		if (newDist < r.dist[V])
+		{
+			r.dist[V] = newDist;
+			r.previous_node[V] = u;
+		}
+	}
+}
+
+template <int N, int... V>
+constexpr void SmallRelaxAll(const SmallGraph<N> & g, SmallRoutes<N> & r, uint64_t unvisited, int u,
+	std::integer_sequence<int, V...>)
+{
+	(SmallRelax<N, V>(g, r, unvisited, u), ...);
+}
+
+// SmallDijkstra() - the README's algorithm almost word for word.
+//
+// Parameters:
+//	const SmallGraph<N> & g	- the graph.
+//	int s					- the initial node.
+// Returns:
+//	SmallRoutes<N>			- the cost to, and previous node of, every node.
+template <int N>
+constexpr SmallRoutes<N> SmallDijkstra(const SmallGraph<N> & g, int s)
+{
+	SmallRoutes<N> r = {};
+	for (int i = 0; i < N; i++)
+	{
+		r.dist[i] = INT_MAX;
+		r.previous_node[i] = -1;
+	}
+	r.dist[s] = 0;
+
+	// Step 1: every node starts in the unvisited set.
+	uint64_t unvisited = N == 64 ? ~0ull : (1ull << N) - 1;
+
+	while (unvisited)
+	{
+		// Step 6: the unvisited node with the smallest tentative cost.
+		int u = -1;
+		for (int v = 0; v < N; v++)
+			if ((unvisited >> v) & 1 && (u == -1 || r.dist[v] < r.dist[u]))
+				u = v;
+
+		// Step 5: everything left is unreachable.
+		if (r.dist[u] == INT_MAX)
+			break;
+
+		// Steps 3 and 4.
+		unvisited &= ~(1ull << u);
+		SmallRelaxAll(g, r, unvisited, u, std::make_integer_sequence<int, N>());
+	}
+	return r;
+}
+
+// SmallAllPairs() - SmallDijkstra() from every node. Assigned to a
+// constexpr variable this is a routing table computed by the compiler.
+template <int N>
+constexpr std::array<SmallRoutes<N>, N> SmallAllPairs(const SmallGraph<N> & g)
+{
+	std::array<SmallRoutes<N>, N> table = {};
+	for (int s = 0; s < N; s++)
+		table[s] = SmallDijkstra(g, s);
+	return table;
+}
+
+// The two example graphs from the README (4x4.txt and 6x6-1.txt) with
+// their routing tables baked in.
+constexpr SmallGraph<4> small_graph_4 = { {
+	-1,  1, -1,  4,
+	 1, -1,  3, -1,
+	-1,  3, -1,  1,
+	 4, -1,  1, -1
+} };
+
+constexpr SmallGraph<6> small_graph_6 = { {
+	-1,  4,  2, -1, -1, -1,
+	 4, -1,  1,  5, -1, -1,
+	 2,  1, -1,  8, 10, -1,
+	-1,  5,  8, -1,  2,  6,
+	-1, -1, 10,  2, -1,  3,
+	-1, -1, -1,  6,  3, -1
+} };
+
+constexpr auto small_routes_4 = SmallAllPairs(small_graph_4);
+constexpr auto small_routes_6 = SmallAllPairs(small_graph_6);
+
+// The README's sample output, checked by the compiler.
+static_assert(small_routes_4[2].dist[0] == 4 && small_routes_4[2].previous_node[0] == 1);
+static_assert(small_routes_4[2].dist[3] == 1 && small_routes_4[2].previous_node[2] == -1);
@@ -10,6 +10,38 @@
 #include <istream>
 #include <vector>
 #include <iomanip>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "GraphView.h"
+#include "Facility.h"
+#include "Apsp.h"
+#include "TiledMatrix.h"
+#include "NextHop.h"
+#include "SmallGraph.h"
+#include "Bench.h"
+#include "AStar.h"
+#include "Jps.h"
+#include "DistributedSssp.h"
+#include "SharedGraph.h"
+#include "ByteSource.h"
+#include "ProgressiveGraph.h"
+#include "GraphFile.h"
+#include "Geometry.h"
+#include "SpatialIndex.h"
+#include "PathWriter.h"
+#include "CostMatrix.h"
+#include "Tsp.h"
+#include "MaxFlow.h"
+#include "MinCostFlow.h"
+#include "AlgebraicPaths.h"
+#include "Reachability.h"
 
 using namespace std;
 
@@ -203,17 +235,1086 @@ void dijkstra(int s)
 	}
 }
 
+// PrintRoutes() - prints the table shown in the README's sample output,
+// with each node's value already converted to text so that values a plain
+// number would misrepresent can be shown as words. The version below
+// takes plain costs.
+void PrintRoutes(int src, const vector<string> & shown, const int * prev)
+{
+	int w = 8;
+	cout << right << setw(3 * w) << "Cum." << right << setw(w) << "Prev" << endl;
+	cout << right << setw(w) << "From:";
+	cout << right << setw(w) << "To:";
+	cout << right << setw(w) << "Cost:";
+	cout << right << setw(w) << "Node:" << endl;
+	for (int i = 0; i < number_of_nodes; i++)
+	{
+		cout << right << setw(w) << src;
+		cout << right << setw(w) << i;
+		cout << right << setw(w) << shown[i];
+		cout << right << setw(w) << prev[i];
+		cout << ((prev[i] == -1) ? " <--<<" : "") << endl;
+	}
+}
+
+// PrintRoutes() - as above, given plain costs.
+//
+// Parameters:
+//	int src					- the initial node.
+//	const int * d			- the cost to each node.
+//	const int * prev		- the previous node on the route to each node.
+// Returns:
+//	none
+void PrintRoutes(int src, const int * d, const int * prev)
+{
+	vector<string> shown(number_of_nodes);
+	for (int i = 0; i < number_of_nodes; i++)
+		shown[i] = to_string(d[i]);
+	PrintRoutes(src, shown, prev);
+}
+
+// ParseNodes() - converts command line arguments into node numbers.
+// Anything out of range is reported and causes failure.
+//
+// Parameters:
+//	int argc		- the number of arguments to convert.
+//	char * argv[]	- the arguments.
+//	vector<int> & nodes	- receives the node numbers.
+// Returns:
+//	bool			- true if every argument was a valid node number.
+bool ParseNodes(int argc, char * argv[], vector<int> & nodes)
+{
+	nodes.clear();
+	for (int i = 0; i < argc; i++)
+	{
+		int v = atoi(argv[i]);
+		if (v < 0 || v >= number_of_nodes)
+		{
+			cerr << "Node number " << argv[i] << " is out of range." << endl;
+			return false;
+		}
+		nodes.push_back(v);
+	}
+	return true;
+}
+
+// Usage() - prints the command line options to cerr.
+void Usage(char * name)
+{
+	cerr << "usage: " << name << " graph_file [command [arguments]]" << endl;
+	cerr << "       " << name << " --standalone_command [arguments]" << endl;
+	cerr << "With no command, asks for an initial node and prints its routes." << endl;
+	cerr << "Commands:" << endl;
+	cerr << "  nearest f...          nearest facility to each node" << endl;
+	cerr << "  rknn k f f...         nodes having facility f among their k nearest" << endl;
+	cerr << "                        (f and the other facilities listed after it)" << endl;
+	cerr << "  pmedian p c...        greedily place p facilities among candidates c" << endl;
+	cerr << "  apsp-tiles out [tile [threads]]" << endl;
+	cerr << "                        write all pairs costs as a compressed tiled matrix" << endl;
+	cerr << "  tile-get file i j     read one cost back from a tiled matrix file" << endl;
+	cerr << "  nexthop s t [threads] build a compressed next hop table and route s to t" << endl;
+	cerr << "  baked s               print routes from s using a table built by the compiler" << endl;
+	cerr << "                        (only for the example graphs in SmallGraph.h)" << endl;
+	cerr << "  dial s [threads [delta]]" << endl;
+	cerr << "                        routes from s by the parallel bucketed search" << endl;
+	cerr << "  frontier s [threads]  routes from s by the parallel frontier search" << endl;
+	cerr << "  distributed s [processes]" << endl;
+	cerr << "                        routes from s by worker processes exchanging messages" << endl;
+	cerr << "  shm-publish name      place the graph in a shared memory object for other" << endl;
+	cerr << "                        processes to attach (name is like /roads)" << endl;
+	cerr << "  save-binary file      write the graph as a binary graph file" << endl;
+	cerr << "  paths json|binary out s [t...]" << endl;
+	cerr << "                        write the routes from s to each t (or every node) with" << endl;
+	cerr << "                        edge costs and costs so far to out (- for the console)" << endl;
+	cerr << "  geo-route coords s t  route s to t by A* using node positions from the side" << endl;
+	cerr << "                        file coords (see Geometry.h)" << endl;
+	cerr << "  snap coords x y       the node nearest the point x y" << endl;
+	cerr << "  snap-edge coords x y  the point on an edge nearest the point x y" << endl;
+	cerr << "  matrix out tile p p [p...]" << endl;
+	cerr << "                        the costs between every pair of the points p as a" << endl;
+	cerr << "                        compressed tiled matrix (out - prints them instead)" << endl;
+	cerr << "  tsp p p p [p...]      a short tour visiting every point p and returning" << endl;
+	cerr << "  maxflow s t           the maximum flow from s to t reading costs as" << endl;
+	cerr << "                        capacities, and the edges of a minimum cut" << endl;
+	cerr << "  best kind s           routes from s that are best by kind: shortest, widest" << endl;
+	cerr << "                        (weights are capacities), reliable (weights are percent" << endl;
+	cerr << "                        chances of getting through) or minimax (smallest worst" << endl;
+	cerr << "                        edge)" << endl;
+	cerr << "  dense kind            the best route value between every pair of nodes by" << endl;
+	cerr << "                        Floyd-Warshall: kind is shortest, widest or reach" << endl;
+	cerr << "  reach s t [s t...]    whether each t can be reached from its s, by a" << endl;
+	cerr << "                        reachability index" << endl;
+	cerr << "  mincost s t amount [capacity]" << endl;
+	cerr << "                        the cheapest way to send amount from s to t when every" << endl;
+	cerr << "                        edge carries at most capacity (default 1)" << endl;
+	cerr << "Standalone commands (no graph file):" << endl;
+	cerr << "  --bench-views [n [sources]]" << endl;
+	cerr << "                        time graph views against hand written searches" << endl;
+	cerr << "  --grid file connectivity from to" << endl;
+	cerr << "                        route across a grid of cell costs (from and to are" << endl;
+	cerr << "                        r,c or z,r,c; connectivity is 4 or 8 in 2D, 6 or 26 in 3D)" << endl;
+	cerr << "  --grid-random rows cols connectivity [blocked% [max_cost]]" << endl;
+	cerr << "                        route corner to corner across a generated grid" << endl;
+	cerr << "  --bench-jps [queries] time A* against the jump point search variants" << endl;
+	cerr << "  --bench-sssp [n [threads [sources]]]" << endl;
+	cerr << "                        time dijkstra() against the parallel searches" << endl;
+	cerr << "  --shm-route name s    routes from s over a graph published by shm-publish" << endl;
+	cerr << "  --shm-remove name     remove a graph published by shm-publish" << endl;
+	cerr << "  --progressive file s t [s t...]" << endl;
+	cerr << "                        answer routing queries while a large graph file loads" << endl;
+	cerr << "  --binary-route file s routes from s over a binary graph file" << endl;
+	cerr << "  --bench-load file [n] time loading a generated binary graph file (written to" << endl;
+	cerr << "                        file, then removed) by mmap, read() and io_uring" << endl;
+	cerr << "  --bench-geometry [n [queries]]" << endl;
+	cerr << "                        time A* with geometric bounds and nearest node lookups" << endl;
+	cerr << "  --bench-snap [n [threads]]" << endl;
+	cerr << "                        time snapping points to nodes and edges" << endl;
+	cerr << "  --bench-matrix [n [points [threads]]]" << endl;
+	cerr << "                        time cost matrices searching every row against the" << endl;
+	cerr << "                        upper triangle only" << endl;
+	cerr << "  --tsp-tiles file [threads]" << endl;
+	cerr << "                        a short tour through every point of a tiled matrix" << endl;
+	cerr << "                        file (from apsp-tiles or matrix)" << endl;
+	cerr << "  --bench-tsp [points [threads]]" << endl;
+	cerr << "                        time tour construction and improvement" << endl;
+	cerr << "  --bench-dense [n]     time Floyd-Warshall in each semiring, with and without" << endl;
+	cerr << "                        SSE2, and reachability as bits" << endl;
+	cerr << "  --bench-flow [n]      time maximum flow on generated graphs" << endl;
+	cerr << "  --bench-reach [n [queries]]" << endl;
+	cerr << "                        time reachability queries by index and by search" << endl;
+	cerr << "  --bench-mincost [n [amount]]" << endl;
+	cerr << "                        time successive shortest paths against cost scaling" << endl;
+	cerr << "  --bench-nexthop [n [threads]]" << endl;
+	cerr << "                        build next hop tables with zero weight edges and check" << endl;
+	cerr << "                        every route" << endl;
+}
+
+// RunCommand() - carries out one of the commands listed in Usage() on
+// the graph that has already been read.
+//
+// Parameters:
+//	int argc		- the number of arguments starting with the command name.
+//	char * argv[]	- the command name followed by its arguments.
+// Returns:
+//	int				- the value main() should return.
+int RunCommand(int argc, char * argv[])
+{
+	string command = argv[0];
+	DenseView view(graph, number_of_nodes);
+	int w = 8;
+	vector<int> nodes;
+
+	if (command == "nearest")
+	{
+		vector<int> cost, owner;
+
+		if (argc < 2 || !ParseNodes(argc - 1, argv + 1, nodes))
+			return 1;
+		NearestFacility(view, nodes, cost, owner);
+		cout << right << setw(w) << "Node:" << setw(w) << "Near:" << setw(w) << "Cost:" << endl;
+		for (int i = 0; i < number_of_nodes; i++)
+			cout << right << setw(w) << i << setw(w) << owner[i] << setw(w) << cost[i] << endl;
+		return 0;
+	}
+	if (command == "rknn")
+	{
+		if (argc < 3 || !ParseNodes(argc - 2, argv + 2, nodes))
+			return 1;
+		int k = atoi(argv[1]);
+		// f is a facility whether or not it is listed again after itself.
+		vector<int> facilities(nodes.begin() + 1, nodes.end());
+		if (find(facilities.begin(), facilities.end(), nodes[0]) == facilities.end())
+			facilities.push_back(nodes[0]);
+		vector<int> served = ReverseKNearest(view, facilities, k, nodes[0]);
+		cout << "Nodes with " << nodes[0] << " among their " << k << " nearest facilities:";
+		for (int v : served)
+			cout << " " << v;
+		cout << endl;
+		return 0;
+	}
+	if (command == "pmedian")
+	{
+		vector<int> best;
+
+		if (argc < 3 || !ParseNodes(argc - 2, argv + 2, nodes))
+			return 1;
+		vector<int> chosen = GreedyPMedian(view, nodes, atoi(argv[1]), best);
+		long long total = 0;
+		cout << "Facilities chosen:";
+		for (int f : chosen)
+			cout << " " << f;
+		cout << endl;
+		for (int i = 0; i < number_of_nodes; i++)
+			if (best[i] != INT_MAX)
+				total += best[i];
+		cout << "Total cost: " << total << endl;
+		return 0;
+	}
+	if (command == "apsp-tiles")
+	{
+		TiledMatrixWriter writer;
+
+		if (argc < 2)
+			return 1;
+		int tile = argc > 2 ? atoi(argv[2]) : 64;
+		int threads = argc > 3 ? atoi(argv[3]) : 0;
+		if (tile <= 0 || !writer.Open(argv[1], number_of_nodes, tile))
+		{
+			cerr << "Could not create: " << argv[1] << endl;
+			return 1;
+		}
+		ParallelApsp(view, threads, [&](int s, const vector<int> & d, const vector<int> &)
+		{
+			writer.AddRow(s, d);
+		});
+		if (!writer.Close())
+		{
+			cerr << "Failed writing: " << argv[1] << endl;
+			return 1;
+		}
+		cout << "Wrote: " << argv[1] << endl;
+		return 0;
+	}
+	if (command == "tile-get")
+	{
+		TiledMatrixReader reader;
+
+		if (argc < 4)
+			return 1;
+		if (!reader.Open(argv[1]))
+		{
+			cerr << "Could not read: " << argv[1] << endl;
+			return 1;
+		}
+		int i = atoi(argv[2]);
+		int j = atoi(argv[3]);
+		if (i < 0 || i >= reader.Size() || j < 0 || j >= reader.Size())
+		{
+			cerr << "Node number is out of range." << endl;
+			return 1;
+		}
+		cout << "Cost from " << i << " to " << j << ": " << reader.Get(i, j) << endl;
+		return 0;
+	}
+	if (command == "nexthop")
+	{
+		NextHopTable table;
+		vector<int> route;
+
+		if (argc < 3 || !ParseNodes(2, argv + 1, nodes))
+			return 1;
+		table.Init(view);
+		ParallelApsp<ShortestFewestEdges>(view, argc > 3 ? atoi(argv[3]) : 0,
+			[&](int s, const vector<int> &, const vector<int> & prev)
+		{
+			table.AddRow(s, prev);
+		});
+		table.Finish();
+		cout << "Runs: " << table.Runs() << " Bytes: " << table.Bytes();
+		cout << " (uncompressed: " << (size_t) number_of_nodes * number_of_nodes * sizeof(int) << ")" << endl;
+		table.Route(nodes[0], nodes[1], route);
+		if (route.empty())
+			cout << "No route from " << nodes[0] << " to " << nodes[1] << endl;
+		else
+		{
+			cout << "Route:";
+			for (int v : route)
+				cout << " " << v;
+			cout << endl;
+		}
+		return 0;
+	}
+	if (command == "baked")
+	{
+		if (argc < 2 || !ParseNodes(1, argv + 1, nodes))
+			return 1;
+		if (number_of_nodes == 4 && equal(graph.begin(), graph.end(), small_graph_4.cost.begin()))
+			PrintRoutes(nodes[0], small_routes_4[nodes[0]].dist.data(), small_routes_4[nodes[0]].previous_node.data());
+		else if (number_of_nodes == 6 && equal(graph.begin(), graph.end(), small_graph_6.cost.begin()))
+			PrintRoutes(nodes[0], small_routes_6[nodes[0]].dist.data(), small_routes_6[nodes[0]].previous_node.data());
+		else
+		{
+			cerr << "There is no built in routing table for this graph." << endl;
+			return 1;
+		}
+		return 0;
+	}
+	if (command == "dial")
+	{
+		vector<int> d, prev;
+
+		if (argc < 2 || !ParseNodes(1, argv + 1, nodes))
+			return 1;
+		ParallelDial(view, nodes[0], argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0, d, prev);
+		PrintRoutes(nodes[0], d.data(), prev.data());
+		return 0;
+	}
+	if (command == "frontier")
+	{
+		vector<int> d, prev;
+		FrontierStats stats;
+
+		if (argc < 2 || !ParseNodes(1, argv + 1, nodes))
+			return 1;
+		FrontierSssp(view, nodes[0], argc > 2 ? atoi(argv[2]) : 0, d, prev, &stats);
+		PrintRoutes(nodes[0], d.data(), prev.data());
+		cout << "Rounds: " << stats.rounds << " (" << stats.dense_rounds << " dense)" << endl;
+		return 0;
+	}
+	if (command == "distributed")
+	{
+		vector<int> d, prev;
+		DistributedStats stats;
+
+		if (argc < 2 || !ParseNodes(1, argv + 1, nodes))
+			return 1;
+		if (!DistributedSssp(view, nodes[0], argc > 2 ? atoi(argv[2]) : 4, d, prev, &stats))
+		{
+			cerr << "The worker processes failed." << endl;
+			return 1;
+		}
+		PrintRoutes(nodes[0], d.data(), prev.data());
+		cout << "Rounds: " << stats.rounds << " Messages: " << stats.messages;
+		cout << " Boundary updates: " << stats.updates << endl;
+		return 0;
+	}
+	if (command == "paths")
+	{
+		vector<int> d, prev;
+		ofstream file;
+
+		if (argc < 4 || (string(argv[1]) != "json" && string(argv[1]) != "binary"))
+			return 1;
+		if (!ParseNodes(argc - 3, argv + 3, nodes))
+			return 1;
+		if (string(argv[2]) != "-")
+		{
+			file.open(argv[2], ios::binary);
+			if (!file.is_open())
+			{
+				cerr << "Could not write " << argv[2] << "." << endl;
+				return 1;
+			}
+		}
+		DijkstraFrom(view, nodes[0], d, prev);
+		PathWriter writer(file.is_open() ? file : cout, string(argv[1]) == "json" ? path_json : path_binary);
+		writer.Begin(nodes[0]);
+		if (nodes.size() == 1)
+			for (int t = 0; t < number_of_nodes; t++)
+				writer.Write(t, d.data(), prev.data());
+		for (size_t i = 1; i < nodes.size(); i++)
+			writer.Write(nodes[i], d.data(), prev.data());
+		writer.End();
+		return 0;
+	}
+	if (command == "matrix")
+	{
+		vector<int> matrix;
+
+		if (argc < 5 || !ParseNodes(argc - 3, argv + 3, nodes))
+			return 1;
+		int k = (int) nodes.size();
+		int tile = atoi(argv[2]);
+		vector<int> sorted = nodes;
+		sort(sorted.begin(), sorted.end());
+		if (adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+		{
+			cerr << "Each point may be given only once." << endl;
+			return 1;
+		}
+		bool symmetric = IsSymmetric(view);
+		if (!symmetric)
+			cerr << "The graph is not symmetric. Searching every row." << endl;
+		CostMatrix(view, nodes, symmetric, 0, matrix);
+		if (string(argv[1]) == "-")
+		{
+			for (int i = 0; i < k; i++)
+			{
+				for (int j = 0; j < k; j++)
+					cout << setw(5) << (matrix[(size_t) i * k + j] == INT_MAX ? -1 : matrix[(size_t) i * k + j]);
+				cout << endl;
+			}
+			return 0;
+		}
+		if (tile <= 0 || !WriteTiledCostMatrix(argv[1], matrix, k, tile))
+		{
+			cerr << "Could not write " << argv[1] << "." << endl;
+			return 1;
+		}
+		cout << "Wrote: " << argv[1] << endl;
+		return 0;
+	}
+	if (command == "tsp")
+	{
+		vector<int> matrix, tour;
+		TspStats stats;
+
+		if (argc < 4 || !ParseNodes(argc - 1, argv + 1, nodes))
+			return 1;
+		int k = (int) nodes.size();
+		vector<int> sorted = nodes;
+		sort(sorted.begin(), sorted.end());
+		if (adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+		{
+			cerr << "Each point may be given only once." << endl;
+			return 1;
+		}
+		CostMatrix(view, nodes, IsSymmetric(view), 0, matrix);
+		TspSolver<DenseCosts> solver(DenseCosts(matrix, k), k);
+		solver.Solve(tour, &stats);
+		if (stats.cost >= INT_MAX)
+		{
+			cerr << "Some points cannot reach each other." << endl;
+			return 1;
+		}
+		cout << "Tour:";
+		for (int i : tour)
+			cout << " " << nodes[i];
+		cout << " " << nodes[tour[0]] << endl;
+		cout << "Cost: " << stats.cost << endl;
+		return 0;
+	}
+	if (command == "maxflow")
+	{
+		if (argc < 3 || !ParseNodes(2, argv + 1, nodes))
+			return 1;
+		MaxFlow flow(view);
+		cout << "Maximum flow from " << nodes[0] << " to " << nodes[1] << ": ";
+		cout << flow.Solve(nodes[0], nodes[1]) << endl;
+		cout << "Minimum cut:";
+		for (auto [u, v] : flow.CutEdges())
+			cout << " " << u << "-" << v;
+		cout << endl;
+		return 0;
+	}
+	if (command == "best")
+	{
+		vector<int> value, prev;
+		vector<double> chance;
+
+		if (argc < 3 || !ParseNodes(1, argv + 2, nodes))
+			return 1;
+		string kind = argv[1];
+		if (kind == "shortest")
+			PathSearch<ShortestPath>(view, nodes[0], value, prev);
+		else if (kind == "widest")
+			PathSearch<WidestPath>(view, nodes[0], value, prev);
+		else if (kind == "minimax")
+			PathSearch<MinimaxPath>(view, nodes[0], value, prev);
+		else if (kind == "reliable")
+		{
+			PathSearch<MostReliable>(view, nodes[0], chance, prev);
+			value.resize(number_of_nodes);
+			for (int v = 0; v < number_of_nodes; v++)
+				value[v] = (int) lround(100 * MostReliable::Chance(chance[v]));
+		}
+		else
+		{
+			cerr << "Unknown kind of route: " << kind << endl;
+			return 1;
+		}
+
+		// A widest route from the source to itself has no narrowest edge
+		// (WidestPath::Source() is INT_MAX) and a node that cannot be
+		// reached has no route at all. Neither is a number to print.
+		vector<string> shown(number_of_nodes);
+		for (int v = 0; v < number_of_nodes; v++)
+		{
+			if (v == nodes[0])
+				shown[v] = kind == "widest" ? "inf" : to_string(value[v]);
+			else if (prev[v] == -1)
+				shown[v] = "none";
+			else
+				shown[v] = to_string(value[v]);
+		}
+		PrintRoutes(nodes[0], shown, prev.data());
+		return 0;
+	}
+	if (command == "dense")
+	{
+		int n = number_of_nodes;
+		vector<int> m;
+
+		if (argc < 2)
+			return 1;
+		string kind = argv[1];
+		if (kind == "shortest")
+		{
+			m = DenseMatrix<MinPlus>(view);
+			FloydWarshall<MinPlus>(m, n);
+			replace(m.begin(), m.end(), MinPlus::Zero(), -1);
+		}
+		else if (kind == "widest")
+		{
+			m = DenseMatrix<MaxMin>(view);
+			FloydWarshall<MaxMin>(m, n);
+		}
+		else if (kind == "reach")
+		{
+			BitMatrix r = ReachabilityMatrix(view);
+			m.resize((size_t) n * n);
+			for (int i = 0; i < n; i++)
+				for (int j = 0; j < n; j++)
+					m[(size_t) i * n + j] = r.Get(i, j);
+		}
+		else
+		{
+			cerr << "Unknown kind of route: " << kind << endl;
+			return 1;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			for (int j = 0; j < n; j++)
+				cout << setw(11) << m[(size_t) i * n + j];
+			cout << endl;
+		}
+		return 0;
+	}
+	if (command == "reach")
+	{
+		ReachabilityIndex index;
+
+		if (argc < 3 || (argc - 1) % 2 != 0 || !ParseNodes(argc - 1, argv + 1, nodes))
+			return 1;
+		index.Build(view);
+		for (size_t i = 0; i < nodes.size(); i += 2)
+		{
+			cout << nodes[i + 1] << (index.Reaches(nodes[i], nodes[i + 1]) ? " can" : " cannot");
+			cout << " be reached from " << nodes[i] << endl;
+		}
+		return 0;
+	}
+	if (command == "mincost")
+	{
+		int64_t cost;
+
+		if (argc < 4 || !ParseNodes(2, argv + 1, nodes))
+			return 1;
+		int64_t amount = atoll(argv[3]);
+		int capacity = argc > 4 ? atoi(argv[4]) : 1;
+		MinCostFlow flow(view, [capacity](int, Edge) { return capacity; });
+		int64_t sent = flow.SuccessiveShortestPaths(nodes[0], nodes[1], amount, cost);
+		if (sent < amount)
+			cerr << "Only " << sent << " can be sent." << endl;
+		cout << "Sent " << sent << " from " << nodes[0] << " to " << nodes[1] << " at cost " << cost << endl;
+		for (auto [u, v, f] : flow.Flows())
+			cout << "  " << u << "-" << v << ": " << f << endl;
+		return 0;
+	}
+	if (command == "save-binary")
+	{
+		if (argc < 2)
+			return 1;
+		if (!SaveGraphFile(view, argv[1]))
+		{
+			cerr << "Could not write " << argv[1] << "." << endl;
+			return 1;
+		}
+		return 0;
+	}
+	if (command == "geo-route" || command == "snap" || command == "snap-edge")
+	{
+		Coordinates c;
+
+		if (argc < 4)
+			return 1;
+		if (!c.Read(argv[1]) || c.Count() != number_of_nodes)
+		{
+			cerr << argv[1] << " does not hold a position for each of the " << number_of_nodes << " nodes." << endl;
+			return 1;
+		}
+		if (command == "snap")
+		{
+			KdTree tree(c);
+			cout << "Nearest node: " << tree.Nearest((float) atof(argv[2]), (float) atof(argv[3])) << endl;
+			return 0;
+		}
+		if (command == "snap-edge")
+		{
+			SpatialIndex index(view, c);
+			EdgeSnap snap = index.NearestEdge((float) atof(argv[2]), (float) atof(argv[3]));
+			if (snap.from == -1)
+				cout << "The graph has no edges." << endl;
+			else
+				cout << "Nearest edge: " << snap.from << " to " << snap.to << ", " << snap.along << " of the way along, at distance " << snap.distance << endl;
+			return 0;
+		}
+		if (!ParseNodes(2, argv + 2, nodes))
+			return 1;
+		GeometricBound bound(view, c);
+		vector<int> d, prev, route;
+		size_t expanded;
+		int t = nodes[1];
+		int cost = AStar(view, nodes[0], t, [&](int u) { return bound(u, t); }, d, prev, &expanded);
+		if (cost == INT_MAX)
+		{
+			cout << "There is no route from " << nodes[0] << " to " << t << "." << endl;
+			return 0;
+		}
+		for (int u = t; u != -1; u = prev[u])
+			route.push_back(u);
+		cout << "Cost " << cost << " (" << expanded << " nodes settled):";
+		for (auto u = route.rbegin(); u != route.rend(); u++)
+			cout << " " << *u;
+		cout << endl;
+		return 0;
+	}
+	if (command == "shm-publish")
+	{
+		if (argc < 2)
+			return 1;
+		if (!PublishSharedGraph(view, argv[1]))
+		{
+			cerr << "Could not create shared memory object " << argv[1] << " (it may already exist)." << endl;
+			return 1;
+		}
+		cout << "Published " << number_of_nodes << " nodes as " << argv[1] << "." << endl;
+		return 0;
+	}
+
+	cerr << "Unknown command: " << command << endl;
+	return 1;
+}
+
+// ReadGrid() - reads a grid of cell costs. The first line holds the size
+// of the grid, either "rows cols" or "layers rows cols". The costs follow,
+// layer by layer, row by row. A cost of -1 marks a blocked cell.
+//
+// Parameters:
+//	const char * path	- the file to read.
+//	vector<int> & cost	- receives the cell costs.
+//	int & layers		- receives the number of layers (1 for a 2D grid).
+//	int & rows			- receives the number of rows.
+//	int & cols			- receives the number of columns.
+// Returns:
+//	bool				- false if the file could not be read.
+bool ReadGrid(const char * path, vector<int> & cost, int & layers, int & rows, int & cols)
+{
+	ifstream in(path);
+	string line;
+	vector<int> size;
+	int v;
+
+	if (!in.is_open() || !getline(in, line))
+	{
+		cerr << "Could not read: " << path << endl;
+		return false;
+	}
+	istringstream first(line);
+	while (first >> v)
+		size.push_back(v);
+	if (size.size() < 2 || size.size() > 3)
+	{
+		cerr << "The grid file must begin with rows and columns (or layers, rows and columns)." << endl;
+		return false;
+	}
+	layers = size.size() == 3 ? size[0] : 1;
+	rows = size[size.size() - 2];
+	cols = size[size.size() - 1];
+	if (layers <= 0 || rows <= 0 || cols <= 0 || (long long) layers * rows * cols > INT_MAX)
+	{
+		cerr << "The grid size is out of range." << endl;
+		return false;
+	}
+	cost.resize((size_t) layers * rows * cols);
+	for (auto & c : cost)
+	{
+		if (!(in >> c))
+		{
+			cerr << "The grid file is not well formed. An eof was reached too early." << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// ParseCell() - converts "r,c" or "z,r,c" into a cell number.
+//
+// Parameters:
+//	const char * text	- the coordinates.
+//	const GridView & g	- the grid they refer to.
+//	int & cell			- receives the cell number.
+// Returns:
+//	bool				- false if the coordinates are malformed or out of range.
+bool ParseCell(const char * text, const GridView & g, int & cell)
+{
+	int a, b, c;
+	int z = 0, r, col;
+	int count = sscanf(text, "%d,%d,%d", &a, &b, &c);
+
+	if (count == 2 && g.Layers() == 1)
+	{
+		r = a;
+		col = b;
+	}
+	else if (count == 3)
+	{
+		z = a;
+		r = b;
+		col = c;
+	}
+	else
+	{
+		cerr << "Bad cell: " << text << endl;
+		return false;
+	}
+	if (z < 0 || z >= g.Layers() || r < 0 || r >= g.Rows() || col < 0 || col >= g.Cols())
+	{
+		cerr << "Cell is out of range: " << text << endl;
+		return false;
+	}
+	cell = g.Cell(z, r, col);
+	if (g.Blocked(cell))
+	{
+		cerr << "Cell is blocked: " << text << endl;
+		return false;
+	}
+	return true;
+}
+
+// RouteGrid() - finds a route from s to t with A* and, where it applies,
+// jump point search, and with dijkstra() too if the grid is small enough
+// for a search of the whole grid to be quick. Prints the costs, times and
+// work done by each.
+//
+// Parameters:
+//	const GridView & g	- the grid.
+//	int s				- the source cell.
+//	int t				- the target cell.
+// Returns:
+//	int					- the value main() should return.
+int RouteGrid(const GridView & g, int s, int t)
+{
+	vector<int> d, prev, path;
+	size_t expanded = 0;
+	int cost = INT_MAX;
+	double seconds;
+
+	if (g.NodeCount() <= 4000000)
+	{
+		seconds = TimeIt([&]() { DijkstraFrom(g, s, d, prev); });
+		cout << "dijkstra(): cost " << d[t] << " in " << seconds << " s (whole grid)" << endl;
+	}
+
+	seconds = TimeIt([&]() { cost = AStar(g, s, t, [&](int u) { return g.Heuristic(u, t); }, d, prev, &expanded); });
+	cout << "A*: cost " << cost << " in " << seconds << " s, " << expanded << " cells settled" << endl;
+	if (cost != INT_MAX)
+	{
+		for (int u = t; u != -1; u = prev[u])
+			path.push_back(u);
+		cout << "Route: " << path.size() << " cells" << endl;
+	}
+
+	JumpPointSearch jps(g);
+	if (jps.Usable())
+	{
+		seconds = TimeIt([&]() { cost = jps.Search(s, t, path, &expanded); });
+		cout << "Jump point search: cost " << cost << " in " << seconds << " s, " << expanded << " jump points settled" << endl;
+	}
+	JumpPointSearch jps_plus_search(g, jps_plus);
+	if (jps_plus_search.Usable())
+	{
+		seconds = TimeIt([&]() { cost = jps_plus_search.Search(s, t, path, &expanded); });
+		cout << "JPS+: cost " << cost << " in " << seconds << " s, " << expanded << " jump points settled" << endl;
+	}
+	return 0;
+}
+
+// RunStandalone() - carries out a command that does not read the demo's
+// graph file, such as a benchmark on generated graphs.
+//
+// Parameters:
+//	int argc		- the number of arguments starting with the command name.
+//	char * argv[]	- the command name followed by its arguments.
+// Returns:
+//	int				- the value main() should return.
+int RunStandalone(int argc, char * argv[])
+{
+	string command = argv[0];
+
+	if (command == "--bench-views")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 100000;
+		int sources = argc > 2 ? atoi(argv[2]) : 20;
+		if (n < 2 || sources < 1)
+			return 1;
+		return BenchViews(n, sources) ? 0 : 1;
+	}
+	if (command == "--bench-jps")
+	{
+		int queries = argc > 1 ? atoi(argv[1]) : 200;
+		if (queries < 1)
+			return 1;
+		return BenchJps(queries) ? 0 : 1;
+	}
+	if (command == "--bench-sssp")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 1000000;
+		int threads = argc > 2 ? atoi(argv[2]) : 0;
+		int sources = argc > 3 ? atoi(argv[3]) : 5;
+		if (n < 2 || sources < 1)
+			return 1;
+		if (threads <= 0)
+			threads = max(1u, thread::hardware_concurrency());
+		return BenchSssp(n, threads, sources) ? 0 : 1;
+	}
+	if (command == "--grid")
+	{
+		vector<int> cost;
+		int layers, rows, cols, s, t;
+
+		if (argc < 5 || !ReadGrid(argv[1], cost, layers, rows, cols))
+			return 1;
+		int connectivity = atoi(argv[2]);
+		if (layers == 1 ? connectivity != 4 && connectivity != 8 : connectivity != 6 && connectivity != 26)
+		{
+			cerr << "Connectivity must be 4 or 8 for 2D grids and 6 or 26 for 3D grids." << endl;
+			return 1;
+		}
+		GridView g(cost, layers, rows, cols, connectivity);
+		if (!ParseCell(argv[3], g, s) || !ParseCell(argv[4], g, t))
+			return 1;
+		return RouteGrid(g, s, t);
+	}
+	if (command == "--grid-random")
+	{
+		if (argc < 4)
+			return 1;
+		int rows = atoi(argv[1]);
+		int cols = atoi(argv[2]);
+		int connectivity = atoi(argv[3]);
+		double blocked = argc > 4 ? atof(argv[4]) / 100 : 0.2;
+		int max_cost = argc > 5 ? atoi(argv[5]) : 1;
+		if (rows <= 0 || cols <= 0 || (long long) rows * cols > INT_MAX || max_cost <= 0 ||
+			(connectivity != 4 && connectivity != 8))
+			return 1;
+		vector<int> cost = RandomCostGrid(rows, cols, max_cost, blocked, 4);
+		cost.front() = cost.back() = 1;
+		if (max_cost == 1)
+			cout << "Uniform cost grid." << endl;
+		GridView g(cost, rows, cols, connectivity);
+		return RouteGrid(g, 0, rows * cols - 1);
+	}
+	if (command == "--shm-route")
+	{
+		SharedGraph g;
+		vector<int> d, prev;
+
+		if (argc < 3)
+			return 1;
+		if (!g.Attach(argv[1]))
+		{
+			cerr << "No complete graph is published as " << argv[1] << "." << endl;
+			return 1;
+		}
+		number_of_nodes = g.NodeCount();
+		vector<int> nodes;
+		if (!ParseNodes(1, argv + 2, nodes))
+			return 1;
+		DijkstraFrom(g, nodes[0], d, prev);
+		PrintRoutes(nodes[0], d.data(), prev.data());
+		return 0;
+	}
+	if (command == "--progressive")
+	{
+		ProgressiveGraph g;
+		vector<int> d, prev;
+
+		if (argc < 4 || argc % 2 != 0)
+			return 1;
+		auto start = chrono::steady_clock::now();
+		string problem;
+		if (!g.Start(argv[1], 0, &problem))
+		{
+			cerr << "Cannot load: " << problem << "." << endl;
+			return 1;
+		}
+		number_of_nodes = g.NodeCount();
+		for (int i = 2; i < argc; i += 2)
+		{
+			vector<int> query;
+			if (!ParseNodes(2, argv + i, query))
+				return 1;
+			int cost = AStar(g, query[0], query[1], [](int) { return 0; }, d, prev);
+			chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+			cout << query[0] << " to " << query[1] << ": cost " << cost << " after " << seconds.count() << " s with ";
+			cout << g.RegionsLoaded() << " of " << g.RegionCount() << " regions loaded" << endl;
+		}
+		bool ok = g.Finish();
+		chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+		cout << "Loading finished after " << seconds.count() << " s" << endl;
+		if (!ok)
+			cerr << "The graph file is not well formed." << endl;
+		return ok ? 0 : 1;
+	}
+	if (command == "--binary-route")
+	{
+		GraphFile g;
+		vector<int> d, prev, nodes;
+
+		if (argc < 3)
+			return 1;
+		if (!g.Load(argv[1]))
+		{
+			cerr << argv[1] << " is not a well formed binary graph file." << endl;
+			return 1;
+		}
+		number_of_nodes = g.NodeCount();
+		if (!ParseNodes(1, argv + 2, nodes))
+			return 1;
+		DijkstraFrom(g, nodes[0], d, prev);
+		PrintRoutes(nodes[0], d.data(), prev.data());
+		return 0;
+	}
+	if (command == "--bench-load")
+	{
+		int n = argc > 2 ? atoi(argv[2]) : 2000000;
+		if (argc < 2 || n < 2)
+			return 1;
+		return BenchLoad(argv[1], n) ? 0 : 1;
+	}
+	if (command == "--bench-geometry")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 200000;
+		int queries = argc > 2 ? atoi(argv[2]) : 50;
+		if (n < 2 || queries < 1)
+			return 1;
+		return BenchGeometry(n, queries) ? 0 : 1;
+	}
+	if (command == "--bench-snap")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 1000000;
+		int threads = argc > 2 ? atoi(argv[2]) : 0;
+		if (n < 2)
+			return 1;
+		if (threads <= 0)
+			threads = max(1u, thread::hardware_concurrency());
+		return BenchSnap(n, threads) ? 0 : 1;
+	}
+	if (command == "--bench-matrix")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 100000;
+		int points = argc > 2 ? atoi(argv[2]) : 100;
+		int threads = argc > 3 ? atoi(argv[3]) : 0;
+		if (n < 2 || points < 2 || points > n)
+			return 1;
+		if (threads <= 0)
+			threads = max(1u, thread::hardware_concurrency());
+		return BenchMatrix(n, points, threads) ? 0 : 1;
+	}
+	if (command == "--tsp-tiles")
+	{
+		TileCache costs;
+		vector<int> tour;
+		TspStats stats;
+
+		if (argc < 2)
+			return 1;
+		if (!costs.Open(argv[1]))
+		{
+			cerr << "Could not read: " << argv[1] << endl;
+			return 1;
+		}
+		int threads = argc > 2 ? atoi(argv[2]) : 0;
+		TspSolver<TileCache> solver(costs, costs.Size(), 8, threads);
+		solver.Solve(tour, &stats);
+		cout << "Tour:";
+		for (int i : tour)
+			cout << " " << i;
+		cout << endl;
+		cout << "Nearest neighbor cost: " << stats.nearest_neighbor << endl;
+		cout << "Cost: " << stats.cost << " after " << stats.two_opt_moves << " 2-opt and ";
+		cout << stats.or_opt_moves << " Or-opt moves" << endl;
+		return 0;
+	}
+	if (command == "--bench-tsp")
+	{
+		int points = argc > 1 ? atoi(argv[1]) : 5000;
+		int threads = argc > 2 ? atoi(argv[2]) : 0;
+		if (points < 5)
+			return 1;
+		if (threads <= 0)
+			threads = max(1u, thread::hardware_concurrency());
+		return BenchTsp(points, threads) ? 0 : 1;
+	}
+	if (command == "--bench-dense")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 1500;
+		if (n < 2)
+			return 1;
+		return BenchDense(n) ? 0 : 1;
+	}
+	if (command == "--bench-reach")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 1000000;
+		int queries = argc > 2 ? atoi(argv[2]) : 100000;
+		if (n < 2 || queries < 1)
+			return 1;
+		return BenchReach(n, queries) ? 0 : 1;
+	}
+	if (command == "--bench-flow")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 1000000;
+		if (n < 2)
+			return 1;
+		return BenchFlow(n) ? 0 : 1;
+	}
+	if (command == "--bench-mincost")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 100000;
+		int64_t amount = argc > 2 ? atoll(argv[2]) : 1000;
+		if (n < 2 || amount < 1)
+			return 1;
+		return BenchMinCost(n, amount) ? 0 : 1;
+	}
+	if (command == "--bench-nexthop")
+	{
+		int n = argc > 1 ? atoi(argv[1]) : 2000;
+		int threads = argc > 2 ? atoi(argv[2]) : 0;
+		if (n < 2)
+			return 1;
+		return BenchNextHop(n, threads) ? 0 : 1;
+	}
+	if (command == "--shm-remove")
+	{
+		if (argc < 2)
+			return 1;
+		if (!RemoveSharedGraph(argv[1]))
+		{
+			cerr << "Could not remove " << argv[1] << "." << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	cerr << "Unknown command: " << command << endl;
+	return 1;
+}
+
 int main(int argc, char * argv[])
 {
+	if (argc > 1 && string(argv[1]).compare(0, 2, "--") == 0)
+	{
+		int status = RunStandalone(argc - 1, argv + 1);
+		if (status != 0)
+			Usage(argv[0]);
+		return status;
+	}
+
 	if (argc > 1)
 	{
-		ifstream in(argv[1]);
+		// The graph file may be compressed. See ByteSource.h.
+		string problem;
+		unique_ptr<ByteSource> in = OpenByteSource(argv[1], &problem);
 		int v;
 
-		if (in.is_open())
+		if (!in)
+			cerr << "Cannot load: " << problem << "." << endl;
+		else
 		{
+			TextIntReader reader(*in);
 			cout << "Opened: " << argv[1] << " for reading." << endl;
-			in >> number_of_nodes;
+			reader.Next(number_of_nodes);
 			cout << "Number of nodes: " << number_of_nodes << endl;
 			// Modest sanity checking of the first value found in the graph file.
 			if (number_of_nodes > 0 && number_of_nodes < max_nodes)
@@ -224,18 +1325,27 @@ int main(int argc, char * argv[])
 
 				for (int i = 0; i < number_of_nodes * number_of_nodes; i++)
 				{
-					if (in.eof())
+					if (!reader.Next(v))
 					{
+						if (in->Failed())
+							cerr << "The compressed graph file is damaged or truncated." << endl;
 						cerr << "The graph file is not well formed. An eof was reached too early." << endl;
 						cerr << "Execution will continue with bogus data purely for entertainment value." << endl;
 						break;
 					}
-					in >> v;
 					GraphSet(i, v);
 				}
-				in.close();
+				in.reset();
 				cout << "Connectivity table read." << endl;
 
+				if (argc > 2)
+				{
+					int status = RunCommand(argc - 2, argv + 2);
+					if (status != 0)
+						Usage(argv[0]);
+					return status;
+				}
+
 				int src;
 				cout << "Enter initial node number [0 to " << number_of_nodes - 1 << "]: ";
 				cin >> src;
@@ -248,20 +1358,7 @@ int main(int argc, char * argv[])
 
 				dijkstra(src);
 
-				int w = 8;
-				cout << right << setw(3 * w) << "Cum." << right << setw(w) << "Prev" << endl;
-				cout << right << setw(w) << "From:";
-				cout << right << setw(w) << "To:";
-				cout << right << setw(w) << "Cost:";
-				cout << right << setw(w) << "Node:" << endl;
-				for (int i = 0; i < number_of_nodes; i++)
-				{
-					cout << right << setw(w) << src;
-					cout << right << setw(w) << i;
-					cout << right << setw(w) << dist[i];
-					cout << right << setw(w) << previous_node[i];
-					cout << ((previous_node[i] == -1) ? " <--<<" : "") << endl;
-				}
+				PrintRoutes(src, dist.data(), previous_node.data());
 			}
 		}
 	}
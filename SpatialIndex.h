@@ -0,0 +1,414 @@
+// Spatial Index for Snapping Points to the Graph
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Queries usually arrive as positions, not node numbers, and must first be
+// snapped to the graph: to the nearest node, or to the nearest point on
+// the nearest edge (a position part way along a road). This is done for
+// every query so it has to be fast.
+//
+// PackedRTree is a static R-tree over line segments (a node is a segment
+// of length zero). It is built once, bottom up:
+//
+//	- the segments are sorted along a Hilbert curve through their centers
+//	  so that each run of them is compact,
+//	- every run of 4 segments becomes a leaf with a bounding box,
+//	- every run of 4 boxes becomes a box on the level above, and so on
+//	  up to a single root.
+//
+// Because every node of the tree has exactly 4 children (except at the
+// right edge) the tree needs no pointers. The children of box i are boxes
+// 4i to 4i + 3 of the level below. Those four children are stored
+// together as one 64 byte block, each coordinate of all four side by
+// side, so visiting a node reads one cache line and its four children
+// are measured at once with SSE2 when the compiler offers it (__SSE2__,
+// which every x86-64 compiler does). Other machines use the plain loop.
+// Wider nodes measured more boxes per visit but read more cache lines,
+// and were slower.
+//
+// A search descends into the nearest child box first and skips any box
+// farther away than the best segment found so far. It allocates nothing.
+//
+// Geographic positions are projected onto a plane (longitude scaled by
+// the cosine of the middle latitude), which is accurate enough to pick
+// the nearest node or edge within a city or region. Distances are then
+// in meters.
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "GraphView.h"
+#include "Geometry.h"
+
+const float rtree_far = 1e30f;
+
+// Four boxes, or four segments, laid out so each coordinate of all four
+// can be loaded at once. 64 bytes: one cache line.
+struct alignas(64) BoxBlock
+{
+	float min_x[4];
+	float min_y[4];
+	float max_x[4];
+	float max_y[4];
+};
+
+struct alignas(64) SegmentBlock
+{
+	float ax[4];
+	float ay[4];
+	float bx[4];
+	float by[4];
+};
+
+class PackedRTree
+{
+public:
+	// Build() - builds the tree over the segments (ax, ay) to (bx, by).
+	// Segment i keeps the number i in the results of Nearest().
+	void Build(const std::vector<float> & ax, const std::vector<float> & ay,
+		const std::vector<float> & bx, const std::vector<float> & by)
+	{
+		size_t n = ax.size();
+		std::vector<uint64_t> key(n);
+		id.resize(n);
+		std::iota(id.begin(), id.end(), 0);
+		if (n > 0)
+		{
+			float x0 = *std::min_element(ax.begin(), ax.end());
+			float x1 = *std::max_element(ax.begin(), ax.end());
+			float y0 = *std::min_element(ay.begin(), ay.end());
+			float y1 = *std::max_element(ay.begin(), ay.end());
+			double sx = 65535.0 / std::max(1e-9, (double) x1 - x0);
+			double sy = 65535.0 / std::max(1e-9, (double) y1 - y0);
+			for (size_t i = 0; i < n; i++)
+			{
+				double cx = std::clamp(((ax[i] + bx[i]) / 2 - x0) * sx, 0.0, 65535.0);
+				double cy = std::clamp(((ay[i] + by[i]) / 2 - y0) * sy, 0.0, 65535.0);
+				key[i] = HilbertIndex((uint32_t) cx, (uint32_t) cy);
+			}
+			std::sort(id.begin(), id.end(), [&](int a, int b) { return key[a] < key[b]; });
+		}
+
+		// The segments in Hilbert order. Unused places in the last block
+		// hold segments too far away to ever be chosen.
+		segments.assign(std::max<size_t>(1, (n + 3) / 4), SegmentBlock());
+		for (auto & b : segments)
+			for (int j = 0; j < 4; j++)
+				b.ax[j] = b.ay[j] = b.bx[j] = b.by[j] = rtree_far;
+		for (size_t i = 0; i < n; i++)
+		{
+			SegmentBlock & b = segments[i / 4];
+			b.ax[i % 4] = ax[id[i]];
+			b.ay[i % 4] = ay[id[i]];
+			b.bx[i % 4] = bx[id[i]];
+			b.by[i % 4] = by[id[i]];
+		}
+		count = n;
+
+		// Box i of level 0 bounds segment block i. Box i of each level
+		// above bounds block i of the level below. Unused places hold
+		// boxes that contain nothing.
+		levels.clear();
+		size_t below = segments.size();
+		do
+		{
+			std::vector<BoxBlock> level((below + 3) / 4);
+			for (auto & b : level)
+			{
+				for (int j = 0; j < 4; j++)
+				{
+					b.min_x[j] = b.min_y[j] = rtree_far;
+					b.max_x[j] = b.max_y[j] = -rtree_far;
+				}
+			}
+			for (size_t i = 0; i < below; i++)
+			{
+				BoxBlock & b = level[i / 4];
+				int k = i % 4;
+				for (int j = 0; j < 4; j++)
+				{
+					float x0, y0, x1, y1;
+					if (levels.empty())
+					{
+						const SegmentBlock & s = segments[i];
+						if (s.ax[j] == rtree_far)
+							continue;
+						x0 = std::min(s.ax[j], s.bx[j]);
+						y0 = std::min(s.ay[j], s.by[j]);
+						x1 = std::max(s.ax[j], s.bx[j]);
+						y1 = std::max(s.ay[j], s.by[j]);
+					}
+					else
+					{
+						const BoxBlock & c = levels.back()[i];
+						x0 = c.min_x[j];
+						y0 = c.min_y[j];
+						x1 = c.max_x[j];
+						y1 = c.max_y[j];
+					}
+					b.min_x[k] = std::min(b.min_x[k], x0);
+					b.min_y[k] = std::min(b.min_y[k], y0);
+					b.max_x[k] = std::max(b.max_x[k], x1);
+					b.max_y[k] = std::max(b.max_y[k], y1);
+				}
+			}
+			below = level.size();
+			levels.push_back(std::move(level));
+		} while (below > 1);
+	}
+
+	// Nearest() - the segment nearest (x, y).
+	//
+	// Parameters:
+	//	float x, y		- the query point.
+	//	float * d2		- if not null, receives the squared distance.
+	// Returns:
+	//	int				- the segment's number or -1 if there are none.
+	int Nearest(float x, float y, float * d2 = nullptr) const
+	{
+		float best = INFINITY;
+		int found = -1;
+		if (count > 0)
+			Search((int) levels.size() - 1, 0, x, y, best, found);
+		if (d2)
+			*d2 = best;
+		return found == -1 ? -1 : id[found];
+	}
+
+private:
+	// Search() - visits block i of a level: four boxes, each bounding a
+	// block of the level below (or, below level 0, a block of segments).
+	void Search(int level, size_t i, float x, float y, float & best, int & found) const
+	{
+		float d[4];
+		if (level < 0)
+		{
+			SegmentDistances(segments[i], x, y, d);
+			for (int j = 0; j < 4; j++)
+			{
+				if (d[j] < best)
+				{
+					best = d[j];
+					found = (int) (4 * i + j);
+				}
+			}
+			return;
+		}
+
+		BoxDistances(levels[level][i], x, y, d);
+		// Nearest box first.
+		int order[4];
+		for (int j = 0; j < 4; j++)
+		{
+			int k = j;
+			for (; k > 0 && d[order[k - 1]] > d[j]; k--)
+				order[k] = order[k - 1];
+			order[k] = j;
+		}
+		for (int j = 0; j < 4 && d[order[j]] < best; j++)
+			Search(level - 1, 4 * i + order[j], x, y, best, found);
+	}
+
+	// BoxDistances() - squared distances from (x, y) to four boxes.
+	static void BoxDistances(const BoxBlock & b, float x, float y, float * d)
+	{
+#ifdef __SSE2__
+		__m128 qx = _mm_set1_ps(x);
+		__m128 qy = _mm_set1_ps(y);
+		__m128 zero = _mm_setzero_ps();
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(b.min_x), qx), _mm_sub_ps(qx, _mm_load_ps(b.max_x))), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_load_ps(b.min_y), qy), _mm_sub_ps(qy, _mm_load_ps(b.max_y))), zero);
+		_mm_storeu_ps(d, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+#else
+		for (int j = 0; j < 4; j++)
+		{
+			float dx = std::max({ b.min_x[j] - x, x - b.max_x[j], 0.0f });
+			float dy = std::max({ b.min_y[j] - y, y - b.max_y[j], 0.0f });
+			d[j] = dx * dx + dy * dy;
+		}
+#endif
+	}
+
+	// SegmentDistances() - squared distances from (x, y) to four segments:
+	// project the point onto each segment's line, clamp to the segment
+	// and measure.
+	static void SegmentDistances(const SegmentBlock & s, float x, float y, float * d)
+	{
+#ifdef __SSE2__
+		__m128 ax = _mm_load_ps(s.ax);
+		__m128 ay = _mm_load_ps(s.ay);
+		__m128 dx = _mm_sub_ps(_mm_load_ps(s.bx), ax);
+		__m128 dy = _mm_sub_ps(_mm_load_ps(s.by), ay);
+		__m128 px = _mm_sub_ps(_mm_set1_ps(x), ax);
+		__m128 py = _mm_sub_ps(_mm_set1_ps(y), ay);
+		__m128 len2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_set1_ps(1e-30f));
+		__m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(px, dx), _mm_mul_ps(py, dy)), len2);
+		t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1));
+		__m128 ex = _mm_sub_ps(px, _mm_mul_ps(t, dx));
+		__m128 ey = _mm_sub_ps(py, _mm_mul_ps(t, dy));
+		_mm_storeu_ps(d, _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+#else
+		for (int j = 0; j < 4; j++)
+		{
+			float dx = s.bx[j] - s.ax[j];
+			float dy = s.by[j] - s.ay[j];
+			float px = x - s.ax[j];
+			float py = y - s.ay[j];
+			float t = std::clamp((px * dx + py * dy) / std::max(dx * dx + dy * dy, 1e-30f), 0.0f, 1.0f);
+			float ex = px - t * dx;
+			float ey = py - t * dy;
+			d[j] = ex * ex + ey * ey;
+		}
+#endif
+	}
+
+	size_t count = 0;
+	std::vector<int> id;
+	std::vector<SegmentBlock> segments;
+	std::vector<std::vector<BoxBlock>> levels;
+};
+
+// The result of snapping a point to an edge: the edge, how far along it
+// the nearest point is (0 at from, 1 at to) and the distance to it.
+struct EdgeSnap
+{
+	int from = -1;
+	int to = -1;
+	float along = 0;
+	float distance = INFINITY;
+};
+
+// SpatialIndex - snaps points to the nodes and edges of a graph.
+class SpatialIndex
+{
+public:
+	template <GraphView G>
+	SpatialIndex(const G & g, const Coordinates & c)
+	{
+		int n = g.NodeCount();
+		scale_x = 1;
+		scale_y = 1;
+		if (c.geographic && n > 0)
+		{
+			auto [low, high] = std::minmax_element(c.y.begin(), c.y.end());
+			double middle = (*low + *high) / 2 * degrees_to_radians;
+			scale_y = (float) (earth_radius * degrees_to_radians);
+			scale_x = (float) (scale_y * std::cos(middle));
+		}
+		x.resize(n);
+		y.resize(n);
+		for (int u = 0; u < n; u++)
+		{
+			x[u] = c.x[u] * scale_x;
+			y[u] = c.y[u] * scale_y;
+		}
+		nodes.Build(x, y, x, y);
+
+		// A two way edge is indexed once, from its lower numbered end.
+		std::vector<float> ax, ay, bx, by;
+		for (int u = 0; u < n; u++)
+		{
+			for (auto e : g.OutEdges(u))
+			{
+				if (e.to == u)
+					continue;
+				if (e.to < u)
+				{
+					bool two_way = false;
+					for (auto back : g.OutEdges(e.to))
+						two_way = two_way || back.to == u;
+					if (two_way)
+						continue;
+				}
+				edges.push_back(std::make_pair(u, (int) e.to));
+				ax.push_back(x[u]);
+				ay.push_back(y[u]);
+				bx.push_back(x[e.to]);
+				by.push_back(y[e.to]);
+			}
+		}
+		edge_tree.Build(ax, ay, bx, by);
+	}
+
+	// NearestNode() - the node nearest a position given in the same terms
+	// as the Coordinates (degrees for geographic positions).
+	int NearestNode(float px, float py) const
+	{
+		return nodes.Nearest(px * scale_x, py * scale_y);
+	}
+
+	// NearestEdge() - the point on any edge nearest a position.
+	EdgeSnap NearestEdge(float px, float py) const
+	{
+		EdgeSnap snap;
+		float d2;
+		float qx = px * scale_x;
+		float qy = py * scale_y;
+		int e = edge_tree.Nearest(qx, qy, &d2);
+		if (e < 0)
+			return snap;
+		snap.from = edges[e].first;
+		snap.to = edges[e].second;
+		float dx = x[snap.to] - x[snap.from];
+		float dy = y[snap.to] - y[snap.from];
+		float len2 = dx * dx + dy * dy;
+		snap.along = len2 > 0 ? std::clamp(((qx - x[snap.from]) * dx + (qy - y[snap.from]) * dy) / len2, 0.0f, 1.0f) : 0;
+		snap.distance = std::sqrt(d2);
+		return snap;
+	}
+
+	// SnapNodes() - NearestNode() for many positions, split across threads.
+	void SnapNodes(const std::vector<float> & px, const std::vector<float> & py, std::vector<int> & out, int threads) const
+	{
+		out.resize(px.size());
+		Batch(px.size(), threads, [&](size_t i) { out[i] = NearestNode(px[i], py[i]); });
+	}
+
+	// SnapEdges() - NearestEdge() for many positions, split across threads.
+	void SnapEdges(const std::vector<float> & px, const std::vector<float> & py, std::vector<EdgeSnap> & out, int threads) const
+	{
+		out.resize(px.size());
+		Batch(px.size(), threads, [&](size_t i) { out[i] = NearestEdge(px[i], py[i]); });
+	}
+
+private:
+	template <typename F>
+	void Batch(size_t count, int threads, F f) const
+	{
+		if (threads <= 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.push_back(std::thread([&, t]()
+			{
+				size_t last = count * (t + 1) / threads;
+				for (size_t i = count * t / threads; i < last; i++)
+					f(i);
+			}));
+		}
+		for (auto & w : workers)
+			w.join();
+	}
+
+	float scale_x;
+	float scale_y;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<std::pair<int, int>> edges;
+	PackedRTree nodes;
+	PackedRTree edge_tree;
+};
@@ -0,0 +1,364 @@
+// Compressed Tiled Distance Matrix
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// All pairs shortest paths produces V * V costs. At 100,000 nodes that is
+// 40 GB of ints, far too much to keep. This file format cuts the matrix
+// into square tiles and squeezes each one separately:
+//
+//	- "frame of reference": the smallest cost in the tile is stored once
+//	  and every entry is stored as its difference from that smallest cost.
+//	- "bit packing": the differences are stored using only as many bits
+//	  as the largest difference needs.
+//
+// Nearby nodes have similar costs to any given destination so the
+// differences within a tile are small and pack tightly.
+//
+// Because every entry of a tile uses the same number of bits, entry (i, j)
+// sits at a computable bit offset within its tile. Reading one cost means
+// finding the tile in the index and pulling out at most two 64 bit words.
+// Nothing else in the tile is decoded.
+//
+// Layout of the file (all values little endian as written by the host):
+//
+//	Header		magic, tile size, number of nodes, offset of the index
+//	Tiles		one after another in the order they were finished
+//	Index		the file offset of every tile, tile row major
+//
+// Each tile is an 8 byte tile header (base cost, bits per entry, flags)
+// followed by the packed entries rounded up to whole 64 bit words.
+// Unreachable entries (INT_MAX) are given the all ones code when a tile
+// contains any, and the flags say so.
+
+#pragma once
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <string>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+const uint32_t tiled_matrix_magic = 0x314d5444;	// "DTM1"
+
+struct TiledMatrixHeader
+{
+	uint32_t magic;
+	uint32_t tile;
+	uint64_t n;
+	uint64_t index_offset;
+	uint64_t reserved;
+};
+
+struct TileHeader
+{
+	int32_t base;
+	uint8_t bits;
+	uint8_t flags;
+	uint16_t reserved;
+};
+
+const uint8_t tile_has_unreachable = 1;
+
+// TileWords() - how many 64 bit words hold count entries of the given width.
+inline uint64_t TileWords(uint64_t count, int bits)
+{
+	return (count * bits + 63) / 64;
+}
+
+// TiledMatrixWriter - accepts rows of the distance matrix in any order
+// from any number of threads. Rows are gathered into bands of tile size
+// rows. When a band is complete its tiles are compressed and appended to
+// the file and the band's memory is released. ParallelApsp() hands out
+// sources in order so only a few bands are ever incomplete at once.
+class TiledMatrixWriter
+{
+public:
+	// Open() - creates the file and reserves room for the header.
+	//
+	// Parameters:
+	//	const std::string & path	- the file to create.
+	//	int n						- the number of nodes.
+	//	int tile					- the width and height of a tile.
+	// Returns:
+	//	bool						- false if the file could not be created.
+	bool Open(const std::string & path, int n, int tile)
+	{
+		this->n = n;
+		this->tile = tile;
+		tiles_across = (n + tile - 1) / tile;
+		bands_written = 0;
+		index.assign((size_t) tiles_across * tiles_across, 0);
+		out.open(path, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+		TiledMatrixHeader h = {};
+		out.write((const char *) &h, sizeof(h));
+		return out.good();
+	}
+
+	// AddRow() - supplies row s of the matrix. Safe to call from many
+	// threads at once. Each row must be supplied exactly once.
+	void AddRow(int s, const std::vector<int> & dist)
+	{
+		int band = s / tile;
+		int first = band * tile;
+		int rows = std::min(tile, n - first);
+		Band * b;
+
+		{
+			std::lock_guard<std::mutex> lock(bands_mutex);
+			b = &bands[band];
+			if (b->data.empty())
+				b->data.resize((size_t) rows * n);
+		}
+		// Different rows land in different parts of the band so no lock
+		// is needed for the copy itself.
+		std::copy(dist.begin(), dist.begin() + n, b->data.begin() + (size_t) (s - first) * n);
+
+		bool complete;
+		{
+			std::lock_guard<std::mutex> lock(bands_mutex);
+			complete = ++b->filled == rows;
+		}
+		if (complete)
+		{
+			WriteBand(band, rows, b->data);
+			std::lock_guard<std::mutex> lock(bands_mutex);
+			bands.erase(band);
+			bands_written++;
+		}
+	}
+
+	// Close() - writes the index and fills in the header.
+	//
+	// Returns:
+	//	bool	- false if any write failed or if rows are missing. A band
+	//			  that received no rows at all has no tiles in the file,
+	//			  so the count of bands written is checked, not just that
+	//			  no band is partly filled.
+	bool Close()
+	{
+		std::lock_guard<std::mutex> lock(file_mutex);
+		TiledMatrixHeader h;
+		h.magic = tiled_matrix_magic;
+		h.tile = tile;
+		h.n = n;
+		h.index_offset = (uint64_t) out.tellp();
+		h.reserved = 0;
+		out.write((const char *) index.data(), index.size() * sizeof(uint64_t));
+		out.seekp(0);
+		out.write((const char *) &h, sizeof(h));
+		bool ok = out.good() && bands.empty() && bands_written == tiles_across;
+		out.close();
+		return ok;
+	}
+
+private:
+	struct Band
+	{
+		std::vector<int> data;
+		int filled = 0;
+	};
+
+	// WriteBand() - compresses each tile of a finished band and appends it.
+	void WriteBand(int band, int rows, const std::vector<int> & data)
+	{
+		std::vector<uint64_t> words;
+
+		for (int tj = 0; tj < tiles_across; tj++)
+		{
+			int first_col = tj * tile;
+			int cols = std::min(tile, n - first_col);
+			int lo = INT_MAX;
+			int hi = INT_MIN;
+			bool unreachable = false;
+
+			for (int r = 0; r < rows; r++)
+			{
+				const int * p = &data[(size_t) r * n + first_col];
+				for (int c = 0; c < cols; c++)
+				{
+					if (p[c] == INT_MAX)
+						unreachable = true;
+					else
+					{
+						lo = std::min(lo, p[c]);
+						hi = std::max(hi, p[c]);
+					}
+				}
+			}
+
+			// The widest code needed is the largest difference from the
+			// base, or one more than that if the all ones code must be
+			// kept free to mean unreachable.
+			TileHeader th = {};
+			uint64_t widest = 0;
+			if (lo == INT_MAX)
+				th.base = INT_MAX;
+			else
+			{
+				th.base = lo;
+				widest = (uint64_t) ((int64_t) hi - lo) + (unreachable ? 1 : 0);
+			}
+			th.flags = unreachable ? tile_has_unreachable : 0;
+			while (th.bits < 64 && (widest >> th.bits) != 0)
+				th.bits++;
+
+			uint64_t mask = th.bits == 64 ? ~0ull : (1ull << th.bits) - 1;
+			words.assign(TileWords((uint64_t) rows * cols, th.bits), 0);
+			uint64_t bit = 0;
+			if (th.bits > 0)
+			{
+				for (int r = 0; r < rows; r++)
+				{
+					const int * p = &data[(size_t) r * n + first_col];
+					for (int c = 0; c < cols; c++, bit += th.bits)
+					{
+						uint64_t code = p[c] == INT_MAX ? mask : (uint64_t) ((int64_t) p[c] - lo);
+						words[bit / 64] |= code << (bit % 64);
+						if (bit % 64 + th.bits > 64)
+							words[bit / 64 + 1] |= code >> (64 - bit % 64);
+					}
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(file_mutex);
+			index[(size_t) band * tiles_across + tj] = (uint64_t) out.tellp();
+			out.write((const char *) &th, sizeof(th));
+			out.write((const char *) words.data(), words.size() * sizeof(uint64_t));
+		}
+	}
+
+	int n = 0;
+	int tile = 0;
+	int tiles_across = 0;
+	std::ofstream out;
+	std::vector<uint64_t> index;
+	std::map<int, Band> bands;
+	int bands_written = 0;
+	std::mutex bands_mutex;
+	std::mutex file_mutex;
+};
+
+// TiledMatrixReader - random access to a file made by TiledMatrixWriter.
+// The index is read into memory when the file is opened. Each Get() then
+// reads one tile header and at most two words of that tile.
+class TiledMatrixReader
+{
+public:
+	// Open() - reads the header and the index.
+	//
+	// Parameters:
+	//	const std::string & path	- the file to read.
+	// Returns:
+	//	bool						- false if the file is missing or not well formed.
+	bool Open(const std::string & path)
+	{
+		TiledMatrixHeader h;
+
+		in.open(path, std::ios::binary);
+		if (!in.is_open())
+			return false;
+		in.read((char *) &h, sizeof(h));
+		if (!in.good() || h.magic != tiled_matrix_magic || h.tile == 0)
+			return false;
+		n = (int) h.n;
+		tile = (int) h.tile;
+		tiles_across = (n + tile - 1) / tile;
+		index.resize((size_t) tiles_across * tiles_across);
+		in.seekg(h.index_offset);
+		in.read((char *) index.data(), index.size() * sizeof(uint64_t));
+		return in.good();
+	}
+
+	int Size() const
+	{
+		return n;
+	}
+
+	// Get() - the cost from node i to node j (INT_MAX if unreachable).
+	int Get(int i, int j)
+	{
+		int ti = i / tile;
+		int tj = j / tile;
+		int cols = std::min(tile, n - tj * tile);
+		TileHeader th;
+
+		in.seekg(index[(size_t) ti * tiles_across + tj]);
+		in.read((char *) &th, sizeof(th));
+		if (th.bits == 0)
+			return th.base;
+
+		uint64_t bit = (uint64_t) ((i - ti * tile) * cols + (j - tj * tile)) * th.bits;
+		uint64_t w[2] = { 0, 0 };
+		bool spans = bit % 64 + th.bits > 64;
+		in.seekg(bit / 64 * sizeof(uint64_t), std::ios::cur);
+		in.read((char *) w, (spans ? 2 : 1) * sizeof(uint64_t));
+
+		uint64_t mask = th.bits == 64 ? ~0ull : (1ull << th.bits) - 1;
+		uint64_t code = w[0] >> (bit % 64);
+		if (spans)
+			code |= w[1] << (64 - bit % 64);
+		code &= mask;
+		if ((th.flags & tile_has_unreachable) && code == mask)
+			return INT_MAX;
+		return (int) (th.base + (int64_t) code);
+	}
+
+	int TileSize() const
+	{
+		return tile;
+	}
+
+	// ReadTile() - decodes every entry of one tile, row by row.
+	//
+	// Parameters:
+	//	int ti, tj				- the tile row and tile column.
+	//	std::vector<int> & out	- receives the entries (the last row and
+	//							  column of tiles may be narrower).
+	// Returns:
+	//	bool					- false if the tile could not be read.
+	bool ReadTile(int ti, int tj, std::vector<int> & out)
+	{
+		int rows = std::min(tile, n - ti * tile);
+		int cols = std::min(tile, n - tj * tile);
+		uint64_t count = (uint64_t) rows * cols;
+		TileHeader th;
+
+		in.seekg(index[(size_t) ti * tiles_across + tj]);
+		in.read((char *) &th, sizeof(th));
+		out.assign(count, th.base);
+		if (th.bits == 0)
+			return in.good();
+
+		std::vector<uint64_t> words(TileWords(count, th.bits) + 1, 0);
+		in.read((char *) words.data(), (words.size() - 1) * sizeof(uint64_t));
+		uint64_t mask = th.bits == 64 ? ~0ull : (1ull << th.bits) - 1;
+		uint64_t bit = 0;
+		for (uint64_t e = 0; e < count; e++, bit += th.bits)
+		{
+			uint64_t code = words[bit / 64] >> (bit % 64);
+			if (bit % 64 + th.bits > 64)
+				code |= words[bit / 64 + 1] << (64 - bit % 64);
+			code &= mask;
+			if ((th.flags & tile_has_unreachable) && code == mask)
+				out[e] = INT_MAX;
+			else
+				out[e] = (int) (th.base + (int64_t) code);
+		}
+		return in.good();
+	}
+
+private:
+	int n = 0;
+	int tile = 0;
+	int tiles_across = 0;
+	std::ifstream in;
+	std::vector<uint64_t> index;
+};
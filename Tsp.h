@@ -0,0 +1,493 @@
+// Travelling Salesman Tours
+//
+// Perry Kivolowitz
+// Assistant Professor, Computer Science
+// Carthage College
+//
+// Route optimization is what most of our dijkstra() results end up
+// feeding: visit every one of a set of points and come back, as cheaply
+// as possible. This file finds a good (not provably best) tour by local
+// search over the cost matrix made by CostMatrix() or read from a tiled
+// matrix file.
+//
+//	- Construction: nearest neighbor. Start somewhere and always go to
+//	  the closest point not yet visited.
+//	- 2-opt: remove two edges of the tour and reconnect the two pieces
+//	  the other way, which reverses the stretch between them.
+//	- Or-opt: lift a run of one to three points out of the tour and put
+//	  it back between two other points, either way round.
+//
+// Both improvements consider only moves that join a point to one of its
+// nearest few points (its neighbor list). A move joining a point to a far
+// away one is almost never an improvement, and without the lists every
+// pass would cost k * k.
+//
+// Finding 2-opt moves is most of the work and only reads the tour, so
+// the points are split among threads, each finding the best move for its
+// points. The moves are then applied one at a time by one thread, each
+// being checked again first since an earlier move may have spoiled it.
+//
+// Reversing a stretch of the tour is only a change for the better if the
+// stretch costs the same both ways. The README promises symmetric graphs
+// so the cost matrix is symmetric too.
+//
+// Costs come from any object with int operator()(int i, int j). Each
+// thread gets its own copy. DenseCosts reads a matrix in memory. TileCache
+// reads a tiled matrix file, keeping recently decoded tiles. Every cost
+// of a tile is decoded at once, which pays off because the points on a
+// neighbor list, and the points along a stretch of tour, tend to share
+// tiles.
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "TiledMatrix.h"
+
+// DenseCosts - costs from a k by k row major matrix in memory.
+class DenseCosts
+{
+public:
+	DenseCosts(const std::vector<int> & matrix, int k) : matrix(&matrix), k(k)
+	{
+	}
+
+	int operator()(int i, int j) const
+	{
+		return (*matrix)[(size_t) i * k + j];
+	}
+
+private:
+	const std::vector<int> * matrix;
+	int k;
+};
+
+// TileCache - costs from a tiled matrix file. Decoded tiles are kept in
+// slots, tile number modulo the number of slots. A copy opens the file
+// again and starts with empty slots so copies can be used by different
+// threads.
+class TileCache
+{
+public:
+	TileCache() = default;
+
+	TileCache(const TileCache & other)
+	{
+		Open(other.path, (int) other.slots.size());
+	}
+
+	TileCache & operator=(const TileCache &) = delete;
+
+	// Open() - opens a tiled matrix file.
+	//
+	// Parameters:
+	//	const std::string & path	- the file.
+	//	int slots					- how many decoded tiles to keep.
+	// Returns:
+	//	bool						- false if the file could not be read.
+	bool Open(const std::string & path, int slots = 256)
+	{
+		this->path = path;
+		this->slots.assign(std::max(1, slots), Slot());
+		if (!reader.Open(path))
+			return false;
+		tile = reader.TileSize();
+		tiles_across = (reader.Size() + tile - 1) / tile;
+		return true;
+	}
+
+	int Size() const
+	{
+		return reader.Size();
+	}
+
+	int operator()(int i, int j)
+	{
+		int ti = i / tile;
+		int tj = j / tile;
+		int64_t id = (int64_t) ti * tiles_across + tj;
+		Slot & s = slots[id % slots.size()];
+		if (s.id != id)
+		{
+			s.id = reader.ReadTile(ti, tj, s.costs) ? id : -1;
+			s.cols = std::min(tile, reader.Size() - tj * tile);
+			if (s.id == -1)
+				return INT_MAX;
+		}
+		return s.costs[(size_t) (i - ti * tile) * s.cols + (j - tj * tile)];
+	}
+
+private:
+	struct Slot
+	{
+		int64_t id = -1;
+		int cols = 0;
+		std::vector<int> costs;
+	};
+
+	std::string path;
+	TiledMatrixReader reader;
+	int tile = 1;
+	int tiles_across = 0;
+	std::vector<Slot> slots;
+};
+
+struct TspStats
+{
+	int64_t nearest_neighbor = 0;	// cost of the first tour
+	int64_t cost = 0;				// cost of the final tour
+	int two_opt_moves = 0;
+	int or_opt_moves = 0;
+};
+
+// TourCost() - the cost of going around the tour and back to its start.
+template <typename C>
+int64_t TourCost(C & costs, const std::vector<int> & tour)
+{
+	int64_t total = 0;
+	for (size_t i = 0; i < tour.size(); i++)
+		total += costs(tour[i], tour[(i + 1) % tour.size()]);
+	return total;
+}
+
+// NearestNeighborTour() - starting at point 0 go to the closest point not
+// yet visited until all have been.
+template <typename C>
+std::vector<int> NearestNeighborTour(C & costs, int k)
+{
+	std::vector<int> tour;
+	std::vector<char> visited(k, 0);
+
+	for (int u = 0; k > 0; )
+	{
+		tour.push_back(u);
+		visited[u] = 1;
+		if ((int) tour.size() == k)
+			break;
+		int next = -1;
+		for (int v = 0; v < k; v++)
+			if (!visited[v] && (next == -1 || costs(u, v) < costs(u, next)))
+				next = v;
+		u = next;
+	}
+	return tour;
+}
+
+// NeighborLists() - the m closest other points to each point, closest
+// first, m to a row.
+template <typename C>
+std::vector<int> NeighborLists(C & costs, int k, int m)
+{
+	std::vector<int> lists((size_t) k * m);
+	std::vector<int> others;
+
+	for (int i = 0; i < k; i++)
+	{
+		others.clear();
+		for (int j = 0; j < k; j++)
+			if (j != i)
+				others.push_back(j);
+		std::partial_sort(others.begin(), others.begin() + m, others.end(),
+			[&](int a, int b) { return costs(i, a) < costs(i, b); });
+		std::copy(others.begin(), others.begin() + m, lists.begin() + (size_t) i * m);
+	}
+	return lists;
+}
+
+// TspSolver - the local search described at the top of this file.
+template <typename C>
+class TspSolver
+{
+public:
+	// Parameters:
+	//	const C & costs	- the costs between points, copied per thread.
+	//	int k			- the number of points.
+	//	int neighbors	- the length of each neighbor list.
+	//	int threads		- threads finding 2-opt moves (0 means one per core).
+	TspSolver(const C & costs, int k, int neighbors = 8, int threads = 0) : costs(costs), k(k)
+	{
+		m = std::max(0, std::min(neighbors, k - 1));
+		this->threads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+		for (int t = 1; t < this->threads; t++)
+			copies.push_back(costs);
+	}
+
+	// Solve() - finds a tour through all the points.
+	//
+	// Parameters:
+	//	std::vector<int> & tour	- receives the points in the order visited.
+	//	TspStats * stats		- if not null receives the costs and moves made.
+	void Solve(std::vector<int> & tour, TspStats * stats = nullptr)
+	{
+		TspStats s;
+
+		t = NearestNeighborTour(costs, k);
+		s.nearest_neighbor = TourCost(costs, t);
+		pos.assign(k, 0);
+		for (int i = 0; i < k; i++)
+			pos[t[i]] = i;
+		if (k >= 5)
+		{
+			near = NeighborLists(costs, k, m);
+			for (bool improved = true; improved; )
+			{
+				int two = TwoOpt();
+				int ins = OrOpt();
+				s.two_opt_moves += two;
+				s.or_opt_moves += ins;
+				improved = two + ins > 0;
+			}
+		}
+		s.cost = TourCost(costs, t);
+		tour = t;
+		if (stats != nullptr)
+			*stats = s;
+	}
+
+private:
+	// A 2-opt move joins a to c. With forward set the edges leaving a and
+	// c are removed, otherwise the edges entering them.
+	struct Move
+	{
+		int64_t gain;
+		int a;
+		int c;
+		bool forward;
+	};
+
+	int Next(int v) const
+	{
+		return t[pos[v] + 1 == k ? 0 : pos[v] + 1];
+	}
+
+	int Prev(int v) const
+	{
+		return t[pos[v] == 0 ? k - 1 : pos[v] - 1];
+	}
+
+	// Gain() - how much the tour would shrink by joining a to c.
+	template <typename D>
+	int64_t Gain(D & d, int a, int c, bool forward) const
+	{
+		int b = forward ? Next(a) : Prev(a);
+		int e = forward ? Next(c) : Prev(c);
+		if (c == b || e == a)
+			return 0;
+		return (int64_t) d(a, b) + d(c, e) - (int64_t) d(a, c) - d(b, e);
+	}
+
+	// FindMoves() - the best 2-opt move joining each of points first to
+	// last - 1 to a neighbor, if any improves the tour.
+	template <typename D>
+	void FindMoves(D & d, int first, int last, std::vector<Move> & found) const
+	{
+		for (int a = first; a < last; a++)
+		{
+			Move best = { 0, a, -1, true };
+			for (int dir = 0; dir < 2; dir++)
+			{
+				bool forward = dir == 0;
+				int leave = d(a, forward ? Next(a) : Prev(a));
+				for (int i = 0; i < m; i++)
+				{
+					int c = near[(size_t) a * m + i];
+					// Joining a to c must pay for itself out of the edge
+					// a gives up. Neighbors are closest first so no later
+					// one can either.
+					if (d(a, c) >= leave)
+						break;
+					int64_t g = Gain(d, a, c, forward);
+					if (g > best.gain)
+						best = { g, a, c, forward };
+				}
+			}
+			if (best.c != -1)
+				found.push_back(best);
+		}
+	}
+
+	// Reverse() - reverses the stretch of tour from position i to position
+	// j going forward (wrapping past the end). The rest of the tour is
+	// reversed instead when it is shorter, which is the same tour.
+	void Reverse(int i, int j)
+	{
+		int length = (j - i + k) % k + 1;
+		if (2 * length > k)
+		{
+			std::swap(i, j);
+			i = (i + 1) % k;
+			j = (j - 1 + k) % k;
+			length = k - length;
+		}
+		for (int s = 0; s < length / 2; s++)
+		{
+			std::swap(t[i], t[j]);
+			pos[t[i]] = i;
+			pos[t[j]] = j;
+			i = i + 1 == k ? 0 : i + 1;
+			j = j == 0 ? k - 1 : j - 1;
+		}
+	}
+
+	// TwoOpt() - finds moves in parallel and applies those that still
+	// improve the tour, best first, until none are found.
+	//
+	// Returns:
+	//	int		- the number of moves made.
+	int TwoOpt()
+	{
+		std::vector<std::vector<Move>> found(threads);
+		int made = 0;
+
+		while (true)
+		{
+			std::vector<std::thread> workers;
+			int chunk = (k + threads - 1) / threads;
+			for (int w = 1; w < threads; w++)
+			{
+				found[w].clear();
+				workers.push_back(std::thread([&, w]()
+				{
+					FindMoves(copies[w - 1], std::min(k, w * chunk), std::min(k, (w + 1) * chunk), found[w]);
+				}));
+			}
+			found[0].clear();
+			FindMoves(costs, 0, std::min(k, chunk), found[0]);
+			for (auto & w : workers)
+				w.join();
+
+			std::vector<Move> moves;
+			for (auto & f : found)
+				moves.insert(moves.end(), f.begin(), f.end());
+			std::sort(moves.begin(), moves.end(), [](const Move & x, const Move & y) { return x.gain > y.gain; });
+
+			int applied = 0;
+			for (auto & mv : moves)
+			{
+				if (Gain(costs, mv.a, mv.c, mv.forward) <= 0)
+					continue;
+				if (mv.forward)
+					Reverse(pos[Next(mv.a)], pos[mv.c]);
+				else
+					Reverse(pos[mv.a], pos[Prev(mv.c)]);
+				applied++;
+			}
+			if (applied == 0)
+				break;
+			made += applied;
+		}
+		return made;
+	}
+
+	// OrOpt() - passes over the tour moving runs of one to three points
+	// next to a neighbor of either end of the run, until a pass finds
+	// nothing to move.
+	//
+	// Returns:
+	//	int		- the number of moves made.
+	int OrOpt()
+	{
+		int made = 0;
+
+		for (bool improved = true; improved; )
+		{
+			improved = false;
+			for (int start = 0; start < k; start++)
+			{
+				for (int length = 1; length <= 3 && length <= k - 4; length++)
+				{
+					if (MoveRun(start, length))
+					{
+						made++;
+						improved = true;
+						break;
+					}
+				}
+			}
+		}
+		return made;
+	}
+
+	// MoveRun() - moves the run of length points starting at position
+	// start to the best place next to a neighbor of its ends, if that
+	// makes the tour cheaper.
+	bool MoveRun(int start, int length)
+	{
+		int first = t[start];
+		int last = t[(start + length - 1) % k];
+		int p = Prev(first);
+		int n = Next(last);
+		int64_t removed = (int64_t) costs(p, first) + costs(last, n) - costs(p, n);
+		auto inside = [&](int v) { return (pos[v] - start + k) % k < length; };
+
+		int64_t best = 0;
+		int best_x = -1;
+		bool best_reversed = false;
+		for (int end = 0; end < 2; end++)
+		{
+			int from = end == 0 ? first : last;
+			for (int i = 0; i < m; i++)
+			{
+				int c = near[(size_t) from * m + i];
+				if (inside(c))
+					continue;
+				// Try the edge after c and the edge before it. Either
+				// way the run goes in between, in whichever direction
+				// is cheaper.
+				for (int side = 0; side < 2; side++)
+				{
+					int x = side == 0 ? c : Prev(c);
+					int y = Next(x);
+					if (inside(x) || inside(y))
+						continue;
+					int64_t plain = (int64_t) costs(x, first) + costs(last, y) - costs(x, y);
+					int64_t flipped = (int64_t) costs(x, last) + costs(first, y) - costs(x, y);
+					int64_t gain = removed - std::min(plain, flipped);
+					if (gain > best)
+					{
+						best = gain;
+						best_x = x;
+						best_reversed = flipped < plain;
+					}
+				}
+			}
+		}
+		if (best_x == -1)
+			return false;
+
+		// Rotate the run to the front, then rebuild the tour with the run
+		// placed after best_x.
+		std::rotate(t.begin(), t.begin() + start, t.end());
+		std::vector<int> run(t.begin(), t.begin() + length);
+		if (best_reversed)
+			std::reverse(run.begin(), run.end());
+		std::vector<int> rebuilt;
+		rebuilt.reserve(k);
+		for (int i = length; i < k; i++)
+		{
+			rebuilt.push_back(t[i]);
+			if (t[i] == best_x)
+				rebuilt.insert(rebuilt.end(), run.begin(), run.end());
+		}
+		t.swap(rebuilt);
+		for (int i = 0; i < k; i++)
+			pos[t[i]] = i;
+		return true;
+	}
+
+	C costs;
+	std::vector<C> copies;
+	int k;
+	int m;
+	int threads;
+	std::vector<int> t;
+	std::vector<int> pos;
+	std::vector<int> near;
+};